@@ -63,6 +63,25 @@ lzo1x_decompress_safe   ( const lzo_bytep src, lzo_uint  src_len,
                                 lzo_bytep dst, lzo_uintp dst_len,
                                 lzo_voidp wrkmem /* NOT USED */ );
 
+/* decompression with 16/32 byte vector copies. Like lzo1x_decompress()
+ * the input is trusted, but *dst_len must hold the size of dst on entry:
+ * copies only overshoot the data where dst has room for it.
+ */
+LZO_EXTERN(int)
+lzo1x_decompress_vec    ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem /* NOT USED */ );
+
+/* safe decompression with vector copies. Like lzo1x_decompress_safe(),
+ * but the length tests are folded into the margin tests of the copies,
+ * so away from the ends of src and dst this runs close to the speed of
+ * lzo1x_decompress_vec().
+ */
+LZO_EXTERN(int)
+lzo1x_decompress_vec_safe ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem /* NOT USED */ );
+
 
 /***********************************************************************
 //
@@ -75,6 +94,43 @@ lzo1x_1_compress        ( const lzo_bytep src, lzo_uint  src_len,
                                 lzo_bytep dst, lzo_uintp dst_len,
                                 lzo_voidp wrkmem );
 
+/* trade compression ratio for speed: accel == 1 gives exactly the output
+ * of lzo1x_1_compress(), larger values skip ahead faster over data that
+ * does not match, approaching the speed of a plain copy on incompressible
+ * input. Needs LZO1X_1_MEM_COMPRESS work memory.
+ */
+LZO_EXTERN(int)
+lzo1x_1_compress_accel  ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem, int accel );
+
+/* compress with a preset dictionary, as if the last 0xbfff bytes of dict
+ * came right before src. Decompress with lzo1x_decompress_dict_safe()
+ * and the same dictionary. Helps most on small blocks that share a lot
+ * of text with the dictionary. Needs LZO1X_1_MEM_COMPRESS work memory.
+ */
+LZO_EXTERN(int)
+lzo1x_1_compress_dict   ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem,
+                          const lzo_bytep dict, lzo_uint dict_len );
+
+/* hash the dictionary once into dictmem (LZO1X_1_MEM_COMPRESS bytes), so
+ * that lzo1x_1_compress_dict_prepared() only has to copy it. dictmem is
+ * not written by the compressor and can be shared between threads; it
+ * refers to dict, which must stay unchanged while it is in use.
+ */
+LZO_EXTERN(int)
+lzo1x_1_prepare_dict    ( lzo_voidp dictmem,
+                          const lzo_bytep dict, lzo_uint dict_len );
+
+LZO_EXTERN(int)
+lzo1x_1_compress_dict_prepared ( const lzo_bytep src, lzo_uint  src_len,
+                                       lzo_bytep dst, lzo_uintp dst_len,
+                                       lzo_voidp wrkmem,
+                                 const lzo_bytep dict, lzo_uint dict_len,
+                                 const lzo_voidp dictmem );
+
 
 /***********************************************************************
 // special compressor versions
@@ -137,6 +193,33 @@ lzo1x_999_compress_level    ( const lzo_bytep src, lzo_uint  src_len,
                                     lzo_callback_p cb,
                                     int compression_level );
 
+/* A reusable LZO1X-999 context for many small blocks: the same output as
+ * lzo1x_999_compress_level(), but the match tables are only cleared once
+ * instead of on every call. The context lives in LZO1X_999_CTX_MEM_SIZE
+ * bytes of caller memory aligned like wrkmem; lzo1x_999_ctx_create()
+ * returns NULL for a bad level. lzo1x_999_ctx_reset() changes the level;
+ * it is never needed between calls. */
+#define LZO1X_999_CTX_MEM_SIZE  LZO1X_999_MEM_COMPRESS
+
+struct lzo1x_999_ctx_t;
+typedef struct lzo1x_999_ctx_t lzo1x_999_ctx_t;
+#define lzo1x_999_ctx_p lzo1x_999_ctx_t __LZO_MMODEL *
+
+LZO_EXTERN(lzo1x_999_ctx_p)
+lzo1x_999_ctx_create        ( lzo_voidp mem, int compression_level );
+
+LZO_EXTERN(int)
+lzo1x_999_ctx_reset         ( lzo1x_999_ctx_p ctx, int compression_level );
+
+LZO_EXTERN(int)
+lzo1x_999_ctx_compress      ( lzo1x_999_ctx_p ctx,
+                              const lzo_bytep src, lzo_uint  src_len,
+                                    lzo_bytep dst, lzo_uintp dst_len,
+                              const lzo_bytep dict, lzo_uint dict_len );
+
+LZO_EXTERN(void)
+lzo1x_999_ctx_destroy       ( lzo1x_999_ctx_p ctx );
+
 LZO_EXTERN(int)
 lzo1x_decompress_dict_safe ( const lzo_bytep src, lzo_uint  src_len,
                                    lzo_bytep dst, lzo_uintp dst_len,
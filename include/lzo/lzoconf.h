@@ -363,6 +363,11 @@ LZO_EXTERN(lzo_uint32_t)
     lzo_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len);
 LZO_EXTERN(const lzo_uint32_tp)
     lzo_get_crc32_table(void);
+/* checksum of buf1 followed by buf2 from the two checksums and len(buf2) */
+LZO_EXTERN(lzo_uint32_t)
+    lzo_adler32_combine(lzo_uint32_t c1, lzo_uint32_t c2, lzo_uint len2);
+LZO_EXTERN(lzo_uint32_t)
+    lzo_crc32_combine(lzo_uint32_t c1, lzo_uint32_t c2, lzo_uint len2);
 
 /* misc. */
 LZO_EXTERN(int) _lzo_config_check(void);
@@ -23,6 +23,8 @@
 #define M3_MAX_OFFSET   0x4000
 #define M4_MAX_OFFSET   0xBFFF
 
+#define MX_MAX_OFFSET   (M1_MAX_OFFSET + M2_MAX_OFFSET)
+
 #define M1_MIN_LEN      2
 #define M1_MAX_LEN      2
 #define M2_MIN_LEN      3
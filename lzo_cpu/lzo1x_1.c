@@ -25,6 +25,7 @@
 
 #ifndef DO_COMPRESS
 #define DO_COMPRESS     lzo1x_1_compress
+#define DO_COMPRESS_ACCEL lzo1x_1_compress_accel
 #endif
 
 #include "lzo1x_c.ch"
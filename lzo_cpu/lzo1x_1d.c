@@ -0,0 +1,109 @@
+/* lzo1x_1d.c -- LZO1X-1 compression with a preset dictionary (local copy for lzo_cpu) */
+#include "lzo_conf.h"
+#if 1 && defined(UA_GET_LE32)
+#undef  LZO_DICT_USE_PTR
+#define LZO_DICT_USE_PTR 0
+#undef  lzo_dict_t
+#define lzo_dict_t lzo_uint16_t
+#endif
+
+#define LZO_NEED_DICT_H 1
+#ifndef D_BITS
+#define D_BITS          14
+#endif
+#define D_INDEX1(d,p)       d = DM(DMUL(0x21,DX3(p,5,5,6)) >> 5)
+#define D_INDEX2(d,p)       d = (d & (D_MASK & 0x7ff)) ^ (D_HIGH | 0x1f)
+#if 1
+#define DINDEX(dv,p)        DM(((DMUL(0x1824429d,dv)) >> (32-D_BITS)))
+#else
+#define DINDEX(dv,p)        DM((dv) + ((dv) >> (32-D_BITS)))
+#endif
+#include "config1x.h"
+#ifndef LZO_DETERMINISTIC
+#define LZO_DETERMINISTIC !(LZO_DICT_USE_PTR)
+#endif
+
+/* the dictionary is kept apart from lzo1x_1.c so that the plain
+ * compressor is built without the extra test in its lookup */
+#define LZO1X_PRESET_DICT 1
+#define do_compress     lzo1x_1_compress_dict_core
+
+#include "lzo1x_c.ch"
+
+
+/***********************************************************************
+// the decompressor can reach back M4_MAX_OFFSET bytes, so only the end
+// of a longer dictionary is used
+************************************************************************/
+
+typedef struct {
+    lzo_dict_t dict[(lzo_uint)1 << D_BITS];
+    lzo_uint dict_len;
+} lzo1x_1_dict_prepared_t;
+
+static void
+dict_window ( const lzo_bytep *dict, lzo_uint *dict_len )
+{
+    if (*dict == NULL || *dict_len < 4)
+    {
+        *dict = NULL;
+        *dict_len = 0;
+    }
+    else if (*dict_len > M4_MAX_OFFSET)
+    {
+        *dict += *dict_len - M4_MAX_OFFSET;
+        *dict_len = M4_MAX_OFFSET;
+    }
+}
+
+
+/***********************************************************************
+// public entry points
+************************************************************************/
+
+LZO_PUBLIC(int)
+lzo1x_1_compress_dict ( const lzo_bytep in , lzo_uint  in_len,
+                              lzo_bytep out, lzo_uintp out_len,
+                              lzo_voidp wrkmem,
+                        const lzo_bytep dict, lzo_uint dict_len )
+{
+    dict_window(&dict, &dict_len);
+    return do_compress_accel(in, in_len, out, out_len, wrkmem, 1,
+                             dict, dict_len, NULL);
+}
+
+LZO_PUBLIC(int)
+lzo1x_1_prepare_dict ( lzo_voidp dictmem,
+                       const lzo_bytep dict, lzo_uint dict_len )
+{
+    lzo1x_1_dict_prepared_t *p = (lzo1x_1_dict_prepared_t *) dictmem;
+
+    LZO_COMPILE_TIME_ASSERT(LZO1X_1_MEM_COMPRESS >= sizeof(*p))
+
+    if (p == NULL)
+        return LZO_E_ERROR;
+    dict_window(&dict, &dict_len);
+    prime_dict(p->dict, dict, dict_len);
+    p->dict_len = dict_len;
+    return LZO_E_OK;
+}
+
+LZO_PUBLIC(int)
+lzo1x_1_compress_dict_prepared ( const lzo_bytep in , lzo_uint  in_len,
+                                       lzo_bytep out, lzo_uintp out_len,
+                                       lzo_voidp wrkmem,
+                                 const lzo_bytep dict, lzo_uint dict_len,
+                                 const lzo_voidp dictmem )
+{
+    const lzo1x_1_dict_prepared_t *p = (const lzo1x_1_dict_prepared_t *) dictmem;
+
+    dict_window(&dict, &dict_len);
+    /* the entries index into the dictionary, so it must be the same one */
+    if (p == NULL || p->dict_len != dict_len)
+        return LZO_E_ERROR;
+    return do_compress_accel(in, in_len, out, out_len, wrkmem, 1,
+                             dict, dict_len, p->dict);
+}
+
+
+/* vim:set ts=4 sw=4 et: */
@@ -0,0 +1,468 @@
+/*
+ * lzo_aio.c -- asynchronous positional file I/O for lzo_cpu
+ * Both backends share a fixed table of request slots. io_uring requests
+ * are resubmitted for the remainder after a short transfer; the thread
+ * backend loops over pread()/pwrite() until the request is complete.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE             /* syscall() */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lzo_aio.h"
+
+#ifndef _WIN32
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__) && !defined(LZO_CPU_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LZO_CPU_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef LZO_CPU_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+enum { AIO_OP_READ, AIO_OP_WRITE };
+
+typedef struct aio_req {
+    int op;
+    int fd;
+    unsigned char *buf;
+    size_t len;
+    size_t done;
+    uint64_t off;
+    void *tag;
+    long long res;
+    struct aio_req *next;
+} aio_req_t;
+
+struct lzo_aio {
+    lzo_aio_backend_t backend;
+    unsigned depth;
+    unsigned inflight;
+    aio_req_t *reqs;
+    aio_req_t *free_list;
+
+#ifdef LZO_CPU_HAVE_IO_URING
+    int ring_fd;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+#endif
+
+    /* thread backend: pending -> helper thread -> done */
+    pthread_t thread;
+    int thread_started;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    aio_req_t *pending_head, *pending_tail;
+    aio_req_t *done_head, *done_tail;
+};
+
+static aio_req_t *req_get(lzo_aio_t *aio) {
+    aio_req_t *r = aio->free_list;
+    if (r) {
+        aio->free_list = r->next;
+        r->next = NULL;
+    }
+    return r;
+}
+
+static void req_put(lzo_aio_t *aio, aio_req_t *r) {
+    r->next = aio->free_list;
+    aio->free_list = r;
+}
+
+/* ---------------------------------------------------------------------- */
+/* pread/pwrite helper thread                                              */
+/* ---------------------------------------------------------------------- */
+
+static void thread_transfer(aio_req_t *r) {
+    while (r->done < r->len) {
+        ssize_t n = (r->op == AIO_OP_READ)
+            ? pread(r->fd, r->buf + r->done, r->len - r->done, (off_t)(r->off + r->done))
+            : pwrite(r->fd, r->buf + r->done, r->len - r->done, (off_t)(r->off + r->done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            r->res = -(long long)errno;
+            return;
+        }
+        if (n == 0) break;
+        r->done += (size_t)n;
+    }
+    r->res = (long long)r->done;
+}
+
+static void *aio_thread(void *opaque) {
+    lzo_aio_t *aio = (lzo_aio_t *)opaque;
+    pthread_mutex_lock(&aio->lock);
+    for (;;) {
+        while (!aio->stop && !aio->pending_head)
+            pthread_cond_wait(&aio->cond, &aio->lock);
+        if (!aio->pending_head) break;
+        aio_req_t *r = aio->pending_head;
+        aio->pending_head = r->next;
+        if (!aio->pending_head) aio->pending_tail = NULL;
+        pthread_mutex_unlock(&aio->lock);
+
+        thread_transfer(r);
+
+        pthread_mutex_lock(&aio->lock);
+        r->next = NULL;
+        if (aio->done_tail) aio->done_tail->next = r;
+        else aio->done_head = r;
+        aio->done_tail = r;
+        pthread_cond_broadcast(&aio->cond);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return NULL;
+}
+
+static int thread_init(lzo_aio_t *aio) {
+    pthread_mutex_init(&aio->lock, NULL);
+    pthread_cond_init(&aio->cond, NULL);
+    if (pthread_create(&aio->thread, NULL, aio_thread, aio) != 0) return -1;
+    aio->thread_started = 1;
+    return 0;
+}
+
+static void thread_queue(lzo_aio_t *aio, aio_req_t *r) {
+    pthread_mutex_lock(&aio->lock);
+    if (aio->pending_tail) aio->pending_tail->next = r;
+    else aio->pending_head = r;
+    aio->pending_tail = r;
+    pthread_cond_broadcast(&aio->cond);
+    pthread_mutex_unlock(&aio->lock);
+}
+
+static aio_req_t *thread_wait(lzo_aio_t *aio) {
+    pthread_mutex_lock(&aio->lock);
+    while (!aio->done_head)
+        pthread_cond_wait(&aio->cond, &aio->lock);
+    aio_req_t *r = aio->done_head;
+    aio->done_head = r->next;
+    if (!aio->done_head) aio->done_tail = NULL;
+    pthread_mutex_unlock(&aio->lock);
+    return r;
+}
+
+/* ---------------------------------------------------------------------- */
+/* io_uring                                                                */
+/* ---------------------------------------------------------------------- */
+
+#ifdef LZO_CPU_HAVE_IO_URING
+
+static int uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* IORING_OP_READ and IORING_OP_WRITE arrived in 5.6 together with the
+ * opcode probe, so an older ring (or one with them disabled) fails here.
+ */
+static int uring_probe(int ring_fd) {
+    size_t size = sizeof(struct io_uring_probe) + 256u * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1u, size);
+    int ok = 0;
+    if (!probe) return -1;
+    if (uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256u) == 0)
+        ok = probe->last_op >= IORING_OP_READ && probe->last_op >= IORING_OP_WRITE &&
+             (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+             (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok ? 0 : -1;
+}
+
+static int uring_init(lzo_aio_t *aio) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    aio->ring_fd = uring_setup(aio->depth, &p);
+    if (aio->ring_fd < 0) return -1;
+    if (uring_probe(aio->ring_fd) != 0) return -1;
+
+    aio->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    aio->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (aio->cq_size > aio->sq_size) aio->sq_size = aio->cq_size;
+        aio->cq_size = aio->sq_size;
+    }
+    aio->sq_ptr = mmap(NULL, aio->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       aio->ring_fd, IORING_OFF_SQ_RING);
+    if (aio->sq_ptr == MAP_FAILED) {
+        aio->sq_ptr = NULL;
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        aio->cq_ptr = aio->sq_ptr;
+    } else {
+        aio->cq_ptr = mmap(NULL, aio->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           aio->ring_fd, IORING_OFF_CQ_RING);
+        if (aio->cq_ptr == MAP_FAILED) {
+            aio->cq_ptr = NULL;
+            return -1;
+        }
+    }
+    aio->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    aio->sqes = (struct io_uring_sqe *)mmap(NULL, aio->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, aio->ring_fd, IORING_OFF_SQES);
+    if (aio->sqes == MAP_FAILED) {
+        aio->sqes = NULL;
+        return -1;
+    }
+
+    unsigned char *sq = (unsigned char *)aio->sq_ptr;
+    unsigned char *cq = (unsigned char *)aio->cq_ptr;
+    aio->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    aio->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    aio->sq_array = (unsigned *)(sq + p.sq_off.array);
+    aio->cq_head = (unsigned *)(cq + p.cq_off.head);
+    aio->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    aio->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    aio->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void uring_fini(lzo_aio_t *aio) {
+    if (aio->sqes) munmap(aio->sqes, aio->sqes_size);
+    if (aio->cq_ptr && aio->cq_ptr != aio->sq_ptr) munmap(aio->cq_ptr, aio->cq_size);
+    if (aio->sq_ptr) munmap(aio->sq_ptr, aio->sq_size);
+    if (aio->ring_fd >= 0) close(aio->ring_fd);
+}
+
+/* Fill the next SQE for the untransferred remainder of `r`. The request
+ * table holds `depth` entries and the SQ at least as many, so there is
+ * always room.
+ */
+static void uring_queue(lzo_aio_t *aio, aio_req_t *r) {
+    unsigned tail = *aio->sq_tail;
+    unsigned idx = tail & *aio->sq_mask;
+    struct io_uring_sqe *sqe = &aio->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (r->op == AIO_OP_READ) ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = r->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(r->buf + r->done);
+    sqe->len = (unsigned)(r->len - r->done);
+    sqe->off = r->off + r->done;
+    sqe->user_data = (uint64_t)(uintptr_t)r;
+    aio->sq_array[idx] = idx;
+    __atomic_store_n(aio->sq_tail, tail + 1u, __ATOMIC_RELEASE);
+    aio->to_submit++;
+}
+
+static int uring_submit(lzo_aio_t *aio, unsigned min_complete) {
+    for (;;) {
+        unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0u;
+        int n = uring_enter(aio->ring_fd, aio->to_submit, min_complete, flags);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return -1;
+        }
+        aio->to_submit -= (unsigned)n < aio->to_submit ? (unsigned)n : aio->to_submit;
+        return 0;
+    }
+}
+
+static aio_req_t *uring_wait(lzo_aio_t *aio) {
+    for (;;) {
+        unsigned head = *aio->cq_head;
+        if (head == __atomic_load_n(aio->cq_tail, __ATOMIC_ACQUIRE)) {
+            if (uring_submit(aio, 1u) != 0) return NULL;
+            continue;
+        }
+        struct io_uring_cqe *cqe = &aio->cqes[head & *aio->cq_mask];
+        aio_req_t *r = (aio_req_t *)(uintptr_t)cqe->user_data;
+        int res = cqe->res;
+        __atomic_store_n(aio->cq_head, head + 1u, __ATOMIC_RELEASE);
+
+        if (res == -EINTR || res == -EAGAIN) {
+            uring_queue(aio, r);
+            continue;
+        }
+        if (res < 0) {
+            r->res = res;
+            return r;
+        }
+        r->done += (size_t)res;
+        if (res > 0 && r->done < r->len) {
+            uring_queue(aio, r);    /* short transfer: go again for the rest */
+            continue;
+        }
+        r->res = (long long)r->done;
+        return r;
+    }
+}
+
+#endif /* LZO_CPU_HAVE_IO_URING */
+
+/* ---------------------------------------------------------------------- */
+/* public API                                                              */
+/* ---------------------------------------------------------------------- */
+
+lzo_aio_t *lzo_aio_create(unsigned depth, lzo_aio_backend_t backend) {
+    if (depth == 0) depth = 1;
+    lzo_aio_t *aio = (lzo_aio_t *)calloc(1u, sizeof(*aio));
+    if (!aio) return NULL;
+    aio->depth = depth;
+    aio->reqs = (aio_req_t *)calloc(depth, sizeof(aio_req_t));
+    if (!aio->reqs) {
+        free(aio);
+        return NULL;
+    }
+    for (unsigned i = 0; i < depth; ++i)
+        req_put(aio, &aio->reqs[i]);
+
+#ifdef LZO_CPU_HAVE_IO_URING
+    aio->ring_fd = -1;
+    if (backend == LZO_AIO_AUTO || backend == LZO_AIO_URING) {
+        if (uring_init(aio) == 0) {
+            aio->backend = LZO_AIO_URING;
+            return aio;
+        }
+        uring_fini(aio);
+        aio->ring_fd = -1;
+        aio->sq_ptr = aio->cq_ptr = NULL;
+        aio->sqes = NULL;
+    }
+#endif
+    if (backend == LZO_AIO_URING || thread_init(aio) != 0) {
+        lzo_aio_destroy(aio);
+        return NULL;
+    }
+    aio->backend = LZO_AIO_THREAD;
+    return aio;
+}
+
+void lzo_aio_destroy(lzo_aio_t *aio) {
+    if (!aio) return;
+    lzo_aio_event_t ev;
+    while (aio->inflight > 0 && lzo_aio_wait(aio, &ev) == 0)
+        ;
+#ifdef LZO_CPU_HAVE_IO_URING
+    if (aio->backend == LZO_AIO_URING) uring_fini(aio);
+#endif
+    if (aio->thread_started) {
+        pthread_mutex_lock(&aio->lock);
+        aio->stop = 1;
+        pthread_cond_broadcast(&aio->cond);
+        pthread_mutex_unlock(&aio->lock);
+        pthread_join(aio->thread, NULL);
+        pthread_cond_destroy(&aio->cond);
+        pthread_mutex_destroy(&aio->lock);
+    }
+    free(aio->reqs);
+    free(aio);
+}
+
+const char *lzo_aio_backend_name(const lzo_aio_t *aio) {
+    return (aio && aio->backend == LZO_AIO_URING) ? "uring" : "thread";
+}
+
+unsigned lzo_aio_inflight(const lzo_aio_t *aio) {
+    return aio->inflight;
+}
+
+static int aio_queue(lzo_aio_t *aio, int op, int fd, void *buf, size_t len,
+                     uint64_t off, void *tag) {
+    aio_req_t *r = req_get(aio);
+    if (!r) return -1;
+    r->op = op;
+    r->fd = fd;
+    r->buf = (unsigned char *)buf;
+    r->len = len;
+    r->done = 0;
+    r->off = off;
+    r->tag = tag;
+    r->res = 0;
+    aio->inflight++;
+#ifdef LZO_CPU_HAVE_IO_URING
+    if (aio->backend == LZO_AIO_URING) {
+        uring_queue(aio, r);
+        return 0;
+    }
+#endif
+    thread_queue(aio, r);
+    return 0;
+}
+
+int lzo_aio_read(lzo_aio_t *aio, int fd, void *buf, size_t len, uint64_t off, void *tag) {
+    return aio_queue(aio, AIO_OP_READ, fd, buf, len, off, tag);
+}
+
+int lzo_aio_write(lzo_aio_t *aio, int fd, const void *buf, size_t len, uint64_t off, void *tag) {
+    return aio_queue(aio, AIO_OP_WRITE, fd, (void *)buf, len, off, tag);
+}
+
+int lzo_aio_submit(lzo_aio_t *aio) {
+#ifdef LZO_CPU_HAVE_IO_URING
+    if (aio->backend == LZO_AIO_URING && aio->to_submit > 0)
+        return uring_submit(aio, 0u);
+#endif
+    (void)aio;
+    return 0;
+}
+
+int lzo_aio_wait(lzo_aio_t *aio, lzo_aio_event_t *ev) {
+    if (aio->inflight == 0) return -1;
+    aio_req_t *r;
+#ifdef LZO_CPU_HAVE_IO_URING
+    if (aio->backend == LZO_AIO_URING)
+        r = uring_wait(aio);
+    else
+#endif
+        r = thread_wait(aio);
+    if (!r) return -1;
+    ev->tag = r->tag;
+    ev->res = r->res;
+    aio->inflight--;
+    req_put(aio, r);
+    return 0;
+}
+
+#else /* _WIN32: no positional async I/O; callers use stdio */
+
+lzo_aio_t *lzo_aio_create(unsigned depth, lzo_aio_backend_t backend) {
+    (void)depth;
+    (void)backend;
+    return NULL;
+}
+
+void lzo_aio_destroy(lzo_aio_t *aio) { (void)aio; }
+const char *lzo_aio_backend_name(const lzo_aio_t *aio) { (void)aio; return "none"; }
+unsigned lzo_aio_inflight(const lzo_aio_t *aio) { (void)aio; return 0; }
+
+int lzo_aio_read(lzo_aio_t *aio, int fd, void *buf, size_t len, uint64_t off, void *tag) {
+    (void)aio; (void)fd; (void)buf; (void)len; (void)off; (void)tag;
+    return -1;
+}
+
+int lzo_aio_write(lzo_aio_t *aio, int fd, const void *buf, size_t len, uint64_t off, void *tag) {
+    (void)aio; (void)fd; (void)buf; (void)len; (void)off; (void)tag;
+    return -1;
+}
+
+int lzo_aio_submit(lzo_aio_t *aio) { (void)aio; return -1; }
+int lzo_aio_wait(lzo_aio_t *aio, lzo_aio_event_t *ev) { (void)aio; (void)ev; return -1; }
+
+#endif /* _WIN32 */
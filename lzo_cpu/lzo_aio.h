@@ -0,0 +1,57 @@
+/* lzo_aio.h - asynchronous positional file I/O for lzo_cpu
+ *
+ * A small queue of pread/pwrite style requests with completion events,
+ * used by the streaming pipeline to keep block reads in flight ahead of
+ * the workers and to write finished blocks without blocking on them.
+ *
+ * Two backends: io_uring through raw syscalls (Linux, when
+ * <linux/io_uring.h> is available and LZO_CPU_NO_IO_URING is not
+ * defined), and a helper thread issuing plain pread()/pwrite(). Requests
+ * always transfer their full length; a shorter result means end of file.
+ */
+#ifndef LZO_AIO_H
+#define LZO_AIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LZO_AIO_AUTO = 0,       /* io_uring if the kernel allows it and has IORING_OP_READ/WRITE, else thread */
+    LZO_AIO_URING,
+    LZO_AIO_THREAD,
+} lzo_aio_backend_t;
+
+typedef struct lzo_aio lzo_aio_t;
+
+typedef struct {
+    void *tag;              /* as passed to lzo_aio_read()/lzo_aio_write() */
+    long long res;          /* bytes transferred, or -errno */
+} lzo_aio_event_t;
+
+/* Create a queue allowing `depth` requests in flight. Returns NULL when the
+ * requested backend is unavailable.
+ */
+lzo_aio_t *lzo_aio_create(unsigned depth, lzo_aio_backend_t backend);
+void lzo_aio_destroy(lzo_aio_t *aio);
+const char *lzo_aio_backend_name(const lzo_aio_t *aio);
+unsigned lzo_aio_inflight(const lzo_aio_t *aio);
+
+/* Queue a transfer; -1 when `depth` requests are already in flight.
+ * Queued requests are started by lzo_aio_submit() or lzo_aio_wait().
+ */
+int lzo_aio_read(lzo_aio_t *aio, int fd, void *buf, size_t len, uint64_t off, void *tag);
+int lzo_aio_write(lzo_aio_t *aio, int fd, const void *buf, size_t len, uint64_t off, void *tag);
+int lzo_aio_submit(lzo_aio_t *aio);
+
+/* Block until a request completes. Returns -1 if nothing is in flight. */
+int lzo_aio_wait(lzo_aio_t *aio, lzo_aio_event_t *ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZO_AIO_H */
@@ -6,6 +6,7 @@
  */
 
 #define _POSIX_C_SOURCE 200112L
+#define _DEFAULT_SOURCE             /* madvise(MADV_HUGEPAGE) */
 
 #include <errno.h>
 #include <limits.h>
@@ -22,16 +23,41 @@
 #ifdef _WIN32
 #include <io.h>
 #include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #endif
 
 #include <lzo/lzo1x.h>
 #include "lzo_levels.h"
+#include "lzo_index.h"
+#include "lzo_pool.h"
+#include "lzo_aio.h"
 
-#define MAGIC_TAG            0x4C5A       /* 'L''Z' */
 #define DEFAULT_THREAD_COUNT 1
 #define MIN_BLOCK_SIZE       (64u * 1024u)
 #define MAX_BLOCK_SIZE       (1024u * 1024u)
-#define LZO_WORK_MEM_SIZE    LZO1X_1_MEM_COMPRESS
+#define STREAM_BLOCK_SIZE    (256u * 1024u)
+#define BLOCK_SIZE_AUTO      ((size_t)-1)  /* --block-size auto */
+#define ADAPT_SAMPLES        16
+#define ADAPT_SAMPLE_SIZE    (64u * 1024u)
+#define ADAPT_MIN_BLOCK_US   250.0         /* smallest worthwhile block, in time */
+#define STREAM_SLOTS_PER_THREAD 2
+
+/* --io: how the streaming pipeline reads and writes regular files */
+enum { STREAM_IO_AUTO = 0, STREAM_IO_URING, STREAM_IO_THREAD, STREAM_IO_SYNC };
+/* per-thread work memory, sized for the largest compressor (-L 999) */
+#define LZO_WORK_MEM_SIZE    (LZO1X_999_MEM_COMPRESS > LZO1X_1_MEM_COMPRESS ? \
+                              LZO1X_999_MEM_COMPRESS : LZO1X_1_MEM_COMPRESS)
+#define WRITE_IOV_BATCH      64
+/* incompressibility probe, see block_is_incompressible() */
+#define PROBE_MIN_BLOCK      (32u * 1024u)
+#define PROBE_RUNS           16u
+#define PROBE_RUN_LEN        256u
+#define PROBE_PREFIX         (16u * 1024u)
 
 typedef struct {
     const unsigned char *in;
@@ -40,47 +66,68 @@ typedef struct {
     size_t comp_size;
     size_t offset;
     unsigned char *out;
+    int stored;             /* payload is the raw block (CONTAINER_FLAG_STORED) */
+    uint32_t sum;           /* checksum of the original block (CONTAINER_FLAG_CHECKSUM) */
+    size_t hist;            /* bytes before `in`/`out` the block may match into (CONTAINER_FLAG_CHAINED) */
 } chunk_t;
 
 /* Global algorithm specifier set from -L. When non-NULL it overrides numeric
  * compression level selection inside compress_block_level(). Expected values
- * are labels like "1x", "1k", "1o", "1l".
+ * are labels like "1x", "1k", "1o", "1l", "1:<accel>" for lzo1x_1 with
+ * an acceleration factor, or "999[:<level>]".
  */
 static const char *g_alg_spec = NULL;
+/* lzo1x_1_compress_accel() factor for ALG_1X; 1 is plain lzo1x_1 */
+static int g_accel = 1;
+#define ACCEL_MAX 65536
+/* lzo1x_999_compress_level() level for ALG_999; 8 is lzo1x_999_compress() */
+static int g_level_999 = 8;
 typedef enum {
     ALG_NONE = 0,
     ALG_1X,
     ALG_1K,
     ALG_1L,
     ALG_1O,
+    ALG_999,
 } alg_t;
 
 static alg_t g_alg = ALG_NONE;
 
+/* --dict: preset dictionary every block is compressed against
+ * (CONTAINER_FLAG_DICT). Only its last CHAIN_WINDOW bytes can be reached,
+ * so g_dict points at those; g_dict_prep is their lzo1x_1 hash table and
+ * g_dict_sum their adler32, which the container stores.
+ */
+static unsigned char *g_dict_buf = NULL;
+static const unsigned char *g_dict = NULL;
+static size_t g_dict_len = 0;
+static void *g_dict_prep = NULL;
+static uint32_t g_dict_sum = 0;
+
 static alg_t alg_from_spec(const char *s);
+static int accel_from_spec(const char *s);
+static int level_999_from_spec(const char *s);
 static const char *alg_to_str(alg_t a);
 static alg_t alg_from_level(int level);
 
 
 typedef struct {
     chunk_t *chunks;
-    size_t chunk_count;
-    _Atomic size_t next_index;
     alg_t compression_alg;
-    _Atomic int status;
-    pthread_mutex_t lock;
+    int allow_stored;       /* output format can mark blocks stored */
+    unsigned checksum;      /* CONTAINER_FLAG_CHECKSUM bits, 0 for none */
 } compress_job_t;
 
 typedef struct {
     chunk_t *chunks;
-    size_t chunk_count;
-    _Atomic size_t next_index;
-    _Atomic int status;
-    pthread_mutex_t lock;
+    unsigned checksum;      /* verify chunks[i].sum after decoding */
 } decompress_job_t;
 
-#define HEAP_ALLOC(var, size) \
-    lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+/* Worker pool shared by every threaded path; threads and their work memory
+ * persist across compress_multi()/decompress_multi()/stream_file() calls.
+ */
+static lzo_pool_t *g_pool = NULL;
+static lzo_pool_sched_t g_sched = LZO_POOL_SCHED_STEAL;
 
 /* Global algorithm specifier set from -L. When non-NULL it overrides numeric
  * compression level selection inside compress_block_level(). Expected values
@@ -90,18 +137,49 @@ typedef struct {
 static alg_t alg_from_spec(const char *s) {
     if (!s) return ALG_NONE;
     if (strcasecmp(s, "1") == 0 || strcasecmp(s, "1x") == 0) return ALG_1X;
+    if (accel_from_spec(s) > 0) return ALG_1X;
+    if (level_999_from_spec(s) > 0) return ALG_999;
     if (strcasecmp(s, "1k") == 0) return ALG_1K;
     if (strcasecmp(s, "1l") == 0) return ALG_1L;
     if (strcasecmp(s, "1o") == 0) return ALG_1O;
     return ALG_NONE;
 }
 
+/* Argument of a "<base>:<n>" label: `dflt` for the bare base label, 0 when
+ * the label has another base or n is not in 1..max.
+ */
+static int spec_arg(const char *s, const char *base, int dflt, int max) {
+    const char *colon = strchr(s, ':');
+    size_t n = colon ? (size_t)(colon - s) : strlen(s);
+    if (n != strlen(base) || strncasecmp(s, base, n) != 0) return 0;
+    if (!colon) return dflt;
+    char *end = NULL;
+    errno = 0;
+    long v = strtol(colon + 1, &end, 10);
+    if (errno || end == colon + 1 || *end || v < 1 || v > max) return 0;
+    return (int)v;
+}
+
+/* Acceleration from a "1:<n>" or "1x:<n>" label: 1 for the plain labels,
+ * 0 when the label or the factor is invalid.
+ */
+static int accel_from_spec(const char *s) {
+    int v = spec_arg(s, "1", 1, ACCEL_MAX);
+    return v ? v : spec_arg(s, "1x", 1, ACCEL_MAX);
+}
+
+/* Level from a "999" or "999:<1..10>" label, 0 when invalid. */
+static int level_999_from_spec(const char *s) {
+    return spec_arg(s, "999", 8, 10);
+}
+
 static const char *alg_to_str(alg_t a) {
     switch (a) {
         case ALG_1X: return "1";
         case ALG_1K: return "1k";
         case ALG_1L: return "1l";
         case ALG_1O: return "1o";
+        case ALG_999: return "999";
         default: return "unknown";
     }
 }
@@ -136,6 +214,61 @@ static void write_u32(unsigned char *p, uint32_t v) {
     p[3] = (unsigned char)((v >> 24) & 0xFFu);
 }
 
+static uint64_t read_u64(const unsigned char *p) {
+    return (uint64_t)read_u32(p) | ((uint64_t)read_u32(p + 4) << 32);
+}
+
+static void write_u64(unsigned char *p, uint64_t v) {
+    write_u32(p, (uint32_t)(v & 0xFFFFFFFFu));
+    write_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+/* Container layouts. Both are followed by a u32 compressed length per
+ * block and then the concatenated block payloads; block offsets are the
+ * 64-bit prefix sums of that table.
+ *
+ *   v1 (MAGIC_TAG):    u16 magic, u32 orig_size, u32 blk_size, u32 nblk
+ *   v2 (MAGIC_TAG_V2): u16 magic, u8 version, u8 flags,
+ *                      u64 orig_size, u32 blk_size, u64 nblk
+ *
+ * With CONTAINER_FLAG_INDEX a v2 container also stores those prefix sums
+ * as u64 offsets[nblk + 1] after the length table, so random access needs
+ * only the two offsets around the requested blocks (see lzo_index.h).
+ * With CONTAINER_FLAG_CRC32 or CONTAINER_FLAG_ADLER32 a table of u32
+ * checksums of the original data follows: one per block, then one for the
+ * whole input, merged from the block sums with the combine functions.
+ * With CONTAINER_FLAG_DICT the u32 adler32 of the preset dictionary comes
+ * last; every block then decodes against that dictionary.
+ *
+ * v1 is what the GPU tool reads and stays the default; v2 is selected with
+ * --format 2 or automatically once the input exceeds 4 GiB.
+ */
+static size_t container_header_size(int format, unsigned flags, size_t nblk) {
+    size_t size = (format == 2 ? HEADER_SIZE_V2 : HEADER_SIZE_V1) + nblk * 4u;
+    if (flags & CONTAINER_FLAG_INDEX) size += (nblk + 1u) * 8u;
+    if (flags & CONTAINER_FLAG_CHECKSUM) size += (nblk + 1u) * 4u;
+    if (flags & CONTAINER_FLAG_DICT) size += 4u;
+    return size;
+}
+
+static size_t write_container_header(unsigned char *p, int format, unsigned flags,
+                                     size_t orig_size, size_t blk_size, size_t nblk) {
+    if (format == 2) {
+        write_u16(p, MAGIC_TAG_V2);
+        p[2] = CONTAINER_VERSION;
+        p[3] = (unsigned char)flags;
+        write_u64(p + 4, (uint64_t)orig_size);
+        write_u32(p + 12, (uint32_t)blk_size);
+        write_u64(p + 16, (uint64_t)nblk);
+        return HEADER_SIZE_V2;
+    }
+    write_u16(p, MAGIC_TAG);
+    write_u32(p + 2, (uint32_t)orig_size);
+    write_u32(p + 6, (uint32_t)blk_size);
+    write_u32(p + 10, (uint32_t)nblk);
+    return HEADER_SIZE_V1;
+}
+
 /* Monotonic timespec diff in milliseconds */
 static double diff_ms_ts(const struct timespec *start, const struct timespec *end) {
     return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1000000.0;
@@ -239,6 +372,166 @@ static unsigned char *read_entire(const char *path, size_t *size_out) {
     return buf;
 }
 
+/* Load the --dict dictionary and, for lzo1x_1, hash it once up front so
+ * that each block only copies the table. Returns 0 on success.
+ */
+static int load_dict(const char *path) {
+    size_t size = 0;
+    g_dict_buf = read_entire(path, &size);
+    if (!g_dict_buf) return -1;
+    if (size < 4u) {
+        fprintf(stderr, "%s: a dictionary needs at least 4 bytes\n", path);
+        return -1;
+    }
+    g_dict_len = size < CHAIN_WINDOW ? size : CHAIN_WINDOW;
+    g_dict = g_dict_buf + (size - g_dict_len);
+    g_dict_sum = lzo_index_checksum(CONTAINER_FLAG_ADLER32, g_dict, g_dict_len);
+    g_dict_prep = malloc(LZO1X_1_MEM_COMPRESS);
+    if (!g_dict_prep) {
+        fprintf(stderr, "malloc failed\n");
+        return -1;
+    }
+    if (lzo1x_1_prepare_dict(g_dict_prep, g_dict, (lzo_uint)g_dict_len) != LZO_E_OK) {
+        fprintf(stderr, "%s: cannot prepare the dictionary\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* A CONTAINER_FLAG_DICT container decodes only against the dictionary it
+ * was compressed with, identified by the adler32 it stores; any other
+ * container must be decoded without --dict.
+ */
+static int check_dict(unsigned flags, uint32_t sum) {
+    if (!(flags & CONTAINER_FLAG_DICT)) {
+        if (!g_dict) return 0;
+        fprintf(stderr, "container was compressed without a dictionary; drop --dict\n");
+        return -1;
+    }
+    if (!g_dict) {
+        fprintf(stderr, "container was compressed with a dictionary; pass it with --dict\n");
+        return -1;
+    }
+    if (sum != g_dict_sum) {
+        fprintf(stderr, "--dict does not match the dictionary the container was compressed with\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Whole-file buffer that is either mmapped or heap allocated. Regular
+ * files are mapped so that workers read from (and, for decompression
+ * output, write into) the page cache directly instead of going through a
+ * full-size copy; stdin, pipes and _WIN32 fall back to the heap.
+ */
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    int mapped;
+    int fd;
+} file_map_t;
+
+static int map_input(const char *path, file_map_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->fd = -1;
+#ifndef _WIN32
+    if (strcmp(path, "-") != 0) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            (uintmax_t)st.st_size <= SIZE_MAX) {
+            void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                close(fd);
+                posix_madvise(p, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+                madvise(p, (size_t)st.st_size, MADV_HUGEPAGE);
+#endif
+                m->data = (unsigned char *)p;
+                m->size = (size_t)st.st_size;
+                m->mapped = 1;
+                return 0;
+            }
+        }
+        if (fd >= 0) close(fd);
+    }
+#endif
+    m->data = read_entire(path, &m->size);
+    return (!m->data && m->size != 0) ? -1 : 0;
+}
+
+/* Prepare a `size`-byte output buffer for `path`. A file that does not
+ * exist yet is created, sized with ftruncate() and mapped shared, so
+ * filling the buffer writes the file; finish_output() then only unmaps it.
+ * An existing file (possibly the input itself) is buffered on the heap and
+ * only replaced by finish_output(), so a failed decode leaves it intact.
+ */
+static int map_output(const char *path, size_t size, file_map_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->fd = -1;
+    m->size = size;
+#ifndef _WIN32
+    if (path && strcmp(path, "-") != 0 && size > 0 && (uintmax_t)size <= (uintmax_t)INTMAX_MAX) {
+        int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0 && ftruncate(fd, (off_t)size) == 0) {
+            void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                m->data = (unsigned char *)p;
+                m->mapped = 1;
+                m->fd = fd;
+                return 0;
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+            remove(path);
+        }
+    }
+#endif
+    m->data = (unsigned char *)malloc(size ? size : 1u);
+    if (!m->data) {
+        fprintf(stderr, "malloc failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void release_map(file_map_t *m) {
+#ifndef _WIN32
+    if (m->mapped) {
+        munmap(m->data, m->size);
+        if (m->fd >= 0) close(m->fd);
+    } else
+#endif
+    {
+        free(m->data);
+    }
+    m->data = NULL;
+    m->mapped = 0;
+    m->fd = -1;
+}
+
+static int write_entire(const char *path, const unsigned char *buf, size_t len);
+
+/* Make the contents of an output buffer from map_output() durable at `path`
+ * and release it. Mapped buffers already are the file.
+ */
+static int finish_output(const char *path, file_map_t *m) {
+    int rc = 0;
+    if (!m->mapped) rc = write_entire(path, m->data, m->size);
+    release_map(m);
+    return rc;
+}
+
+/* Drop a partially written output: unmap it and remove the file, which
+ * map_output() only maps when it created it.
+ */
+static void abort_output(const char *path, file_map_t *m) {
+    int mapped = m->mapped;
+    release_map(m);
+    if (mapped) remove(path);
+}
+
 static int write_entire(const char *path, const unsigned char *buf, size_t len) {
     if (!buf && len > 0) return -1;
     int to_stdout = (path && strcmp(path, "-") == 0);
@@ -269,27 +562,116 @@ static int write_entire(const char *path, const unsigned char *buf, size_t len)
     return 0;
 }
 
+/* Bytes written for a chunk: the compressed slot, or for a block stored by
+ * compress_multi() the input itself. Parsed containers leave `in` NULL and
+ * point `comp` at the stored bytes.
+ */
+static const unsigned char *chunk_payload(const chunk_t *ck) {
+    return (ck->stored && ck->in) ? ck->in : ck->comp;
+}
+
+/* Write `head` followed by every chunk's compressed bytes without first
+ * gathering them into one buffer: POSIX builds hand the chunk buffers to
+ * writev() WRITE_IOV_BATCH at a time, _WIN32 falls back to fwrite() per chunk.
+ */
+static int write_chunks(const char *path, const unsigned char *head, size_t head_len,
+                        const chunk_t *chunks, size_t chunk_count) {
+    int to_stdout = (path && strcmp(path, "-") == 0);
+#ifndef _WIN32
+    int fd = to_stdout ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (to_stdout) fflush(stdout);
+
+    struct iovec iov[WRITE_IOV_BATCH];
+    size_t next = 0;            /* next chunk to queue; head is queued first */
+    int head_done = 0, rc = 0;
+    while (rc == 0 && (!head_done || next < chunk_count)) {
+        int n = 0;
+        if (!head_done) {
+            iov[n].iov_base = (void *)head;
+            iov[n++].iov_len = head_len;
+            head_done = 1;
+        }
+        for (; n < WRITE_IOV_BATCH && next < chunk_count; ++next) {
+            if (chunks[next].comp_size == 0) continue;
+            iov[n].iov_base = (void *)chunk_payload(&chunks[next]);
+            iov[n++].iov_len = chunks[next].comp_size;
+        }
+        /* writev may stop short; advance through the batch until it is out */
+        struct iovec *v = iov;
+        while (n > 0) {
+            ssize_t w = writev(fd, v, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                rc = -1;
+                break;
+            }
+            size_t left = (size_t)w;
+            while (n > 0 && left >= v->iov_len) {
+                left -= v->iov_len;
+                ++v;
+                --n;
+            }
+            if (n > 0) {
+                v->iov_base = (unsigned char *)v->iov_base + left;
+                v->iov_len -= left;
+            }
+        }
+    }
+    if (rc != 0) fprintf(stderr, "short write to %s\n", to_stdout ? "stdout" : path);
+    if (!to_stdout && close(fd) != 0) rc = -1;
+    return rc;
+#else
+    FILE *fp;
+    if (to_stdout) {
+        fp = stdout;
+        _setmode(_fileno(stdout), _O_BINARY);
+    } else {
+        fp = fopen(path, "wb");
+    }
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    int ok = fwrite(head, 1u, head_len, fp) == head_len;
+    for (size_t i = 0; ok && i < chunk_count; ++i)
+        ok = fwrite(chunk_payload(&chunks[i]), 1u, chunks[i].comp_size, fp) == chunks[i].comp_size;
+    if (!ok) fprintf(stderr, "short write to %s\n", to_stdout ? "stdout" : path);
+    if (to_stdout) fflush(fp);
+    else fclose(fp);
+    return ok ? 0 : -1;
+#endif
+}
+
 static int compress_block_level(const unsigned char *in, size_t in_size,
                                 unsigned char **out, size_t *out_size,
                                 alg_t compression_alg, void *wrkmem_in) {
     size_t cap = in_size + in_size / 16u + 64u + 3u;
     *out = (unsigned char *)malloc(cap);
     if (!*out) return LZO_E_OUT_OF_MEMORY;
-    lzo_align_t *wrkmem_ptr = NULL;
-    /* if caller provided wrkmem, use it; otherwise allocate on stack */
-    if (wrkmem_in) {
-        wrkmem_ptr = (lzo_align_t *)wrkmem_in;
-    } else {
-        HEAP_ALLOC(_wrkmem_local, LZO_WORK_MEM_SIZE);
-        wrkmem_ptr = _wrkmem_local;
+    /* use the caller's wrkmem; without one, allocate it for this call
+     * (LZO_WORK_MEM_SIZE covers LZO1X-999 and is too big for the stack) */
+    void *wrkmem_local = NULL;
+    if (!wrkmem_in && posix_memalign(&wrkmem_local, sizeof(lzo_align_t), LZO_WORK_MEM_SIZE) != 0) {
+        free(*out);
+        *out = NULL;
+        return LZO_E_OUT_OF_MEMORY;
     }
+    lzo_align_t *wrkmem_ptr = (lzo_align_t *)(wrkmem_in ? wrkmem_in : wrkmem_local);
 
     lzo_uint dst_len = (lzo_uint)cap;
     int rc;
     /* Choose implementation by algorithm enum (caller resolves g_alg/level). */
     switch (compression_alg) {
         case ALG_1X:
-            rc = lzo1x_1_compress(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr);
+            if (g_dict)
+                rc = lzo1x_1_compress_dict_prepared(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr,
+                                                    g_dict, (lzo_uint)g_dict_len, g_dict_prep);
+            else
+                rc = lzo1x_1_compress_accel(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr, g_accel);
             break;
         case ALG_1K:
             rc = lzo1x_1_12_compress(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr);
@@ -300,10 +682,15 @@ static int compress_block_level(const unsigned char *in, size_t in_size,
         case ALG_1L:
             rc = lzo1x_1_11_compress(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr);
             break;
+        case ALG_999:
+            rc = lzo1x_999_compress_level(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr,
+                                          g_dict, (lzo_uint)g_dict_len, NULL, g_level_999);
+            break;
         default:
             rc = lzo1x_1_compress(in, (lzo_uint)in_size, *out, &dst_len, wrkmem_ptr);
             break;
     }
+    free(wrkmem_local);
         if (rc != LZO_E_OK) {
             free(*out);
             *out = NULL;
@@ -314,71 +701,138 @@ static int compress_block_level(const unsigned char *in, size_t in_size,
 }
 
 /* forward decl for the prealloc variant used by workers */
-static int compress_block_into(const unsigned char *in, size_t in_size,
+static int compress_block_into(const unsigned char *in, size_t in_size, size_t hist,
                                unsigned char *out, size_t out_cap, size_t *out_size,
                                alg_t compression_alg, void *wrkmem_in);
 
+/* A block with `hist` > 0 was primed with the hist bytes before it, which
+ * must already be decoded in front of `out`. Other blocks decode against
+ * the --dict dictionary when there is one.
+ */
 static int decompress_block(const unsigned char *in, size_t in_size,
-                            unsigned char *out, size_t orig_size) {
+                            unsigned char *out, size_t orig_size, size_t hist) {
     lzo_uint dst_len = (lzo_uint)orig_size;
-    int rc = lzo1x_decompress(in, (lzo_uint)in_size, out, &dst_len, NULL);
-    return (rc == LZO_E_OK && dst_len == (lzo_uint)orig_size) ? LZO_E_OK : rc;
+    int rc = hist
+        ? lzo1x_decompress_dict_safe(in, (lzo_uint)in_size, out, &dst_len, NULL,
+                                     out - hist, (lzo_uint)hist)
+        : g_dict
+        ? lzo1x_decompress_dict_safe(in, (lzo_uint)in_size, out, &dst_len, NULL,
+                                     g_dict, (lzo_uint)g_dict_len)
+        : lzo1x_decompress_safe(in, (lzo_uint)in_size, out, &dst_len, NULL);
+    if (rc == LZO_E_OK && dst_len != (lzo_uint)orig_size) rc = LZO_E_ERROR;
+    return rc;
+}
+
+/* Cheap test for blocks not worth compressing. An order-0 histogram over
+ * PROBE_RUNS short runs spread across the block (runs rather than single
+ * bytes, so it costs a few cache lines) must be close to flat: the sum of
+ * squared counts within 25% of its expectation for uniform bytes. Random
+ * data that repeats also passes that, and LZO handles it well, so a trial
+ * compression of the first PROBE_PREFIX bytes must then save less than
+ * 1/64. `scratch` needs room for the compressed prefix.
+ */
+static int block_is_incompressible(const unsigned char *in, size_t in_size,
+                                   unsigned char *scratch, size_t scratch_cap,
+                                   alg_t compression_alg, void *wrkmem) {
+    if (in_size < PROBE_MIN_BLOCK) return 0;
+    uint32_t hist[256] = {0};
+    size_t stride = in_size / PROBE_RUNS;
+    for (size_t r = 0; r < PROBE_RUNS; ++r) {
+        const unsigned char *run = in + r * stride;
+        for (size_t i = 0; i < PROBE_RUN_LEN; ++i)
+            hist[run[i]]++;
+    }
+    uint64_t sumsq = 0;
+    for (int i = 0; i < 256; ++i)
+        sumsq += (uint64_t)hist[i] * hist[i];
+    uint64_t n = PROBE_RUNS * PROBE_RUN_LEN;
+    if (sumsq * 256u * 4u > (n * n + 256u * n) * 5u) return 0;
+
+    /* the probe only needs a rough answer; 999 would spend longer on it */
+    if (compression_alg == ALG_999) compression_alg = ALG_1X;
+    size_t out_len = 0;
+    if (compress_block_into(in, PROBE_PREFIX, 0, scratch, scratch_cap, &out_len,
+                            compression_alg, wrkmem) != LZO_E_OK)
+        return 0;
+    return out_len >= PROBE_PREFIX - PROBE_PREFIX / 64u;
+}
+
+/* Compress one block into `out`, or report it stored: *stored is set when
+ * the probe skipped it or when compressing did not make it smaller, and
+ * *out_size is then in_size while `out` holds no usable data.
+ */
+static int compress_or_store(const unsigned char *in, size_t in_size, size_t hist,
+                             unsigned char *out, size_t out_cap, size_t *out_size,
+                             int *stored, alg_t compression_alg, void *wrkmem) {
+    *stored = 0;
+    if (block_is_incompressible(in, in_size, out, out_cap, compression_alg, wrkmem)) {
+        *stored = 1;
+        *out_size = in_size;
+        return LZO_E_OK;
+    }
+    int rc = compress_block_into(in, in_size, hist, out, out_cap, out_size, compression_alg, wrkmem);
+    if (rc == LZO_E_OK && *out_size >= in_size) {
+        *stored = 1;
+        *out_size = in_size;
+    }
+    return rc;
 }
 
+/* Chunks from compress_multi() share one output arena owned by chunk 0. */
 static void free_compression_chunks(chunk_t *chunks, size_t chunk_count) {
     if (!chunks) return;
-    for (size_t i = 0; i < chunk_count; ++i) {
-        free(chunks[i].comp);
-    }
+    if (chunk_count > 0) free(chunks[0].comp);
     free(chunks);
 }
 
-static void *compress_worker(void *opaque) {
-    compress_job_t *job = (compress_job_t *)opaque;
-    lzo_align_t *thread_wrkmem = NULL;
-    int have_wrkmem = 0;
-    /* try to allocate per-thread workspace to reuse across compress calls */
-    if (posix_memalign((void **)&thread_wrkmem, sizeof(lzo_align_t), LZO_WORK_MEM_SIZE) == 0) {
-        have_wrkmem = 1;
-    } else {
-        thread_wrkmem = NULL;
-        have_wrkmem = 0;
+/* Return the shared pool, (re)creating it when the thread count changes. */
+static lzo_pool_t *get_pool(int threads) {
+    if (threads < 1) threads = 1;
+    if (!g_pool || lzo_pool_threads(g_pool) != threads) {
+        lzo_pool_destroy(g_pool);
+        g_pool = lzo_pool_create(threads, LZO_WORK_MEM_SIZE);
+        if (!g_pool) return NULL;
     }
-    while (1) {
-        /* atomic scheduling: fetch next index without lock */
-        size_t idx = atomic_fetch_add(&job->next_index, (size_t)1);
-        if (idx >= job->chunk_count) break;
-        if (atomic_load(&job->status) != LZO_E_OK) break;
+    lzo_pool_set_sched(g_pool, g_sched);
+    return g_pool;
+}
 
-        chunk_t *ck = &job->chunks[idx];
-        size_t out_len = 0;
-        int rc;
-        if (ck->comp) {
-            /* compress into preallocated buffer */
-            size_t cap = ck->in_size + ck->in_size / 16u + 64u + 3u;
-            rc = compress_block_into(ck->in, ck->in_size, ck->comp, cap, &out_len, job->compression_alg, thread_wrkmem);
-            if (rc != LZO_E_OK) {
-                atomic_store(&job->status, rc);
-                break;
-            }
-            ck->comp_size = out_len;
-        } else {
-            unsigned char *out = NULL;
-            rc = compress_block_level(ck->in, ck->in_size, &out, &out_len, job->compression_alg, thread_wrkmem);
-            if (rc != LZO_E_OK) {
-                atomic_store(&job->status, rc);
-                break;
-            }
-            ck->comp = out;
-            ck->comp_size = out_len;
-        }
+static int compress_task(void *opaque, size_t idx, void *wrkmem) {
+    compress_job_t *job = (compress_job_t *)opaque;
+    chunk_t *ck = &job->chunks[idx];
+    size_t out_len = 0;
+    int rc;
+    if (ck->comp) {
+        /* compress into preallocated buffer */
+        size_t cap = ck->in_size + ck->in_size / 16u + 64u + 3u;
+        if (job->allow_stored)
+            rc = compress_or_store(ck->in, ck->in_size, ck->hist, ck->comp, cap, &out_len,
+                                   &ck->stored, job->compression_alg, wrkmem);
+        else
+            rc = compress_block_into(ck->in, ck->in_size, ck->hist, ck->comp, cap, &out_len,
+                                     job->compression_alg, wrkmem);
+        if (rc != LZO_E_OK) return rc;
+        ck->comp_size = out_len;
+    } else {
+        unsigned char *out = NULL;
+        rc = compress_block_level(ck->in, ck->in_size, &out, &out_len, job->compression_alg, wrkmem);
+        if (rc != LZO_E_OK) return rc;
+        ck->comp = out;
+        ck->comp_size = out_len;
     }
-    if (have_wrkmem && thread_wrkmem) free(thread_wrkmem);
-    return NULL;
+    /* the block is still warm in cache from the compressor */
+    if (job->checksum) ck->sum = lzo_index_checksum(job->checksum, ck->in, ck->in_size);
+    return LZO_E_OK;
 }
 
+/* With `chained` set every block after the first is primed with up to
+ * CHAIN_WINDOW bytes of the input before it. The blocks still compress in
+ * parallel, since that history is plain input, but must then be decoded
+ * in order.
+ */
 static int compress_multi(const unsigned char *input, size_t input_size,
                           size_t block_size, int threads, int level,
+                          int allow_stored, unsigned checksum, int chained,
                           chunk_t **chunks_out, size_t *chunk_count_out,
                           double *elapsed_ms, size_t *total_comp_out) {
     if (threads < 1) threads = 1;
@@ -396,31 +850,44 @@ static int compress_multi(const unsigned char *input, size_t input_size,
             chunks[i].in = input + off;
             chunks[i].in_size = (left < block_size || block_size == 0) ? left : block_size;
             chunks[i].offset = off;
+            chunks[i].hist = !chained ? 0 : off < CHAIN_WINDOW ? off : CHAIN_WINDOW;
         }
     }
 
-    /* Preallocate per-chunk output buffers to avoid malloc/free in workers. */
+    /* Carve every chunk's worst-case output slot from one arena instead of
+     * a malloc per chunk. Only the compressed bytes of each slot are ever
+     * touched, so the untouched tails cost address space, not memory.
+     */
     if (chunk_count > 0) {
+        size_t max_in = chunks[0].in_size;   /* the first chunk is the largest */
+        size_t cap = max_in + max_in / 16u + 64u + 3u;
+        if (chunk_count > SIZE_MAX / cap) {
+            free(chunks);
+            return LZO_E_OUT_OF_MEMORY;
+        }
+        unsigned char *arena = (unsigned char *)malloc(chunk_count * cap);
+        if (!arena) {
+            free(chunks);
+            return LZO_E_OUT_OF_MEMORY;
+        }
         for (size_t i = 0; i < chunk_count; ++i) {
-            size_t in_sz = chunks[i].in_size;
-            size_t cap = in_sz + in_sz / 16u + 64u + 3u;
-            chunks[i].comp = (unsigned char *)malloc(cap);
-            if (!chunks[i].comp) {
-                free_compression_chunks(chunks, chunk_count);
-                return LZO_E_OUT_OF_MEMORY;
-            }
+            chunks[i].comp = arena + i * cap;
             chunks[i].comp_size = 0;
         }
     }
 
     compress_job_t job;
     job.chunks = chunks;
-    job.chunk_count = chunk_count;
-    atomic_store(&job.next_index, (size_t)0);
     /* prefer explicit algorithm selection; fall back to numeric mapping */
     job.compression_alg = (g_alg != ALG_NONE) ? g_alg : alg_from_level(level);
-    atomic_store(&job.status, LZO_E_OK);
-    pthread_mutex_init(&job.lock, NULL);
+    job.allow_stored = allow_stored;
+    job.checksum = checksum;
+
+    lzo_pool_t *pool = chunk_count > 0 ? get_pool(threads) : NULL;
+    if (chunk_count > 0 && !pool) {
+        free_compression_chunks(chunks, chunk_count);
+        return LZO_E_OUT_OF_MEMORY;
+    }
 
     /* use monotonic clock to avoid wall-clock adjustments */
 #ifdef CLOCK_MONOTONIC_RAW
@@ -431,27 +898,11 @@ static int compress_multi(const unsigned char *input, size_t input_size,
     struct timespec ts_start, ts_end;
     clock_gettime(clk, &ts_start);
 
-    pthread_t *workers = NULL;
-    if (chunk_count > 0) {
-        workers = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
-        if (!workers) {
-            pthread_mutex_destroy(&job.lock);
-            free_compression_chunks(chunks, chunk_count);
-            return LZO_E_OUT_OF_MEMORY;
-        }
-        for (int i = 0; i < threads; ++i)
-            pthread_create(&workers[i], NULL, compress_worker, &job);
-        for (int i = 0; i < threads; ++i)
-            pthread_join(workers[i], NULL);
-    }
+    int status = chunk_count > 0 ? lzo_pool_run(pool, chunk_count, compress_task, &job) : LZO_E_OK;
 
     clock_gettime(clk, &ts_end);
     if (elapsed_ms) *elapsed_ms = diff_ms_ts(&ts_start, &ts_end);
 
-    int status = atomic_load(&job.status);
-    pthread_mutex_destroy(&job.lock);
-    free(workers);
-
     if (status != LZO_E_OK) {
         free_compression_chunks(chunks, chunk_count);
         return status;
@@ -469,43 +920,36 @@ static int compress_multi(const unsigned char *input, size_t input_size,
     return LZO_E_OK;
 }
 
-static void *decompress_worker(void *opaque) {
+static int decompress_task(void *opaque, size_t idx, void *wrkmem) {
     decompress_job_t *job = (decompress_job_t *)opaque;
-    while (1) {
-        size_t idx = atomic_fetch_add(&job->next_index, (size_t)1);
-        if (idx >= job->chunk_count) break;
-        if (atomic_load(&job->status) != LZO_E_OK) break;
-
-        chunk_t *ck = &job->chunks[idx];
-        int rc = decompress_block(ck->comp, ck->comp_size, ck->out, ck->in_size);
-        if (rc != LZO_E_OK) {
-            atomic_store(&job->status, rc);
-            break;
-        }
+    chunk_t *ck = &job->chunks[idx];
+    int rc = LZO_E_OK;
+    (void)wrkmem;
+    if (ck->stored)
+        memcpy(ck->out, chunk_payload(ck), ck->in_size);
+    else
+        rc = decompress_block(ck->comp, ck->comp_size, ck->out, ck->in_size, ck->hist);
+    if (rc == LZO_E_OK && job->checksum &&
+        lzo_index_checksum(job->checksum, ck->out, ck->in_size) != ck->sum) {
+        fprintf(stderr, "checksum mismatch in block %zu\n", idx);
+        rc = LZO_E_ERROR;
     }
-    return NULL;
+    return rc;
 }
 
-static int decompress_multi(chunk_t *chunks, size_t chunk_count,
-                            int threads, double *elapsed_ms) {
+/* Chained blocks match into the output of the ones before them, so they
+ * are decoded in order on the calling thread.
+ */
+static int decompress_multi(chunk_t *chunks, size_t chunk_count, int threads,
+                            unsigned checksum, int chained, double *elapsed_ms) {
     if (threads < 1) threads = 1;
     if (chunk_count == 0) {
         if (elapsed_ms) *elapsed_ms = 0.0;
         return LZO_E_OK;
     }
 
-    decompress_job_t job;
-    job.chunks = chunks;
-    job.chunk_count = chunk_count;
-    atomic_store(&job.next_index, (size_t)0);
-    atomic_store(&job.status, LZO_E_OK);
-    pthread_mutex_init(&job.lock, NULL);
-
-    pthread_t *workers = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
-    if (!workers) {
-        pthread_mutex_destroy(&job.lock);
-        return LZO_E_OUT_OF_MEMORY;
-    }
+    lzo_pool_t *pool = chained ? NULL : get_pool(threads);
+    if (!chained && !pool) return LZO_E_OUT_OF_MEMORY;
 
     struct timespec ts_start, ts_end;
 #ifdef CLOCK_MONOTONIC_RAW
@@ -514,16 +958,19 @@ static int decompress_multi(chunk_t *chunks, size_t chunk_count,
     const clockid_t clk = CLOCK_MONOTONIC;
 #endif
     clock_gettime(clk, &ts_start);
-    for (int i = 0; i < threads; ++i)
-        pthread_create(&workers[i], NULL, decompress_worker, &job);
-    for (int i = 0; i < threads; ++i)
-        pthread_join(workers[i], NULL);
+    decompress_job_t job;
+    job.chunks = chunks;
+    job.checksum = checksum;
+    int status = LZO_E_OK;
+    if (chained) {
+        for (size_t i = 0; i < chunk_count && status == LZO_E_OK; ++i)
+            status = decompress_task(&job, i, NULL);
+    } else {
+        status = lzo_pool_run(pool, chunk_count, decompress_task, &job);
+    }
     clock_gettime(clk, &ts_end);
 
     if (elapsed_ms) *elapsed_ms = diff_ms_ts(&ts_start, &ts_end);
-    int status = atomic_load(&job.status);
-    pthread_mutex_destroy(&job.lock);
-    free(workers);
     return status;
 }
 
@@ -561,7 +1008,7 @@ static void run_benchmark(const unsigned char *data, size_t size,
         return;
     }
     clock_gettime(clk, &t0);
-    rc = decompress_block(single_comp, single_comp_len, single_out, size);
+    rc = decompress_block(single_comp, single_comp_len, single_out, size, 0);
     clock_gettime(clk, &t1);
     double single_decomp_ms = diff_ms_ts(&t0, &t1);
     fprintf(stderr, "Single  Compress : %.3f ms (%.2f MB/s)\n",
@@ -578,7 +1025,7 @@ static void run_benchmark(const unsigned char *data, size_t size,
     size_t chunk_count = 0;
     double multi_comp_ms = 0.0;
     size_t total_comp = 0;
-    rc = compress_multi(data, size, block_size, threads, level,
+    rc = compress_multi(data, size, block_size, threads, level, 0, 0, 0,
                         &chunks, &chunk_count, &multi_comp_ms, &total_comp);
     if (rc != LZO_E_OK) {
         fprintf(stderr, "multi compress failed: %d\n", rc);
@@ -602,7 +1049,7 @@ static void run_benchmark(const unsigned char *data, size_t size,
         chunks[i].out = multi_out + chunks[i].offset;
 
     double multi_decomp_ms = 0.0;
-    rc = decompress_multi(chunks, chunk_count, threads, &multi_decomp_ms);
+    rc = decompress_multi(chunks, chunk_count, threads, 0, 0, &multi_decomp_ms);
     fprintf(stderr, "Multi   Decompress: %.3f ms (%.2f MB/s) verify=%s\n",
             multi_decomp_ms,
             size ? (size / 1048576.0) / (multi_decomp_ms / 1000.0) : 0.0,
@@ -613,37 +1060,192 @@ static void run_benchmark(const unsigned char *data, size_t size,
     free_compression_chunks(chunks, chunk_count);
 }
 
+/* Compare the shared-counter and work-stealing schedulers at 1..128
+ * threads. Blocks are fixed at MIN_BLOCK_SIZE so that scheduling overhead
+ * is as visible as possible; each figure is the best of a few runs.
+ */
+static void run_sched_benchmark(const unsigned char *data, size_t size, int level) {
+    static const lzo_pool_sched_t scheds[] = { LZO_POOL_SCHED_ATOMIC, LZO_POOL_SCHED_STEAL };
+    static const char *const sched_names[] = { "atomic", "steal" };
+    const int reps = 5;
+    lzo_pool_sched_t saved = g_sched;
+
+    if (size == 0) {
+        fprintf(stderr, "\n== Scheduler benchmark ==\nInput is empty; skipping benchmark.\n");
+        return;
+    }
+    unsigned char *out = (unsigned char *)malloc(size);
+    if (!out) {
+        fprintf(stderr, "malloc failed\n");
+        return;
+    }
+    size_t block_size = size < MIN_BLOCK_SIZE ? size : MIN_BLOCK_SIZE;
+    fprintf(stderr, "\n== Scheduler benchmark (%zu blocks of %zu bytes, best of %d) ==\n",
+            (size + block_size - 1u) / block_size, block_size, reps);
+
+    for (int threads = 1; threads <= 128; threads *= 2) {
+        fprintf(stderr, "threads=%-3d", threads);
+        for (size_t s = 0; s < sizeof(scheds) / sizeof(scheds[0]); ++s) {
+            g_sched = scheds[s];
+            double best_c = 0.0, best_d = 0.0;
+            int ok = 1;
+            for (int r = 0; r < reps && ok; ++r) {
+                chunk_t *chunks = NULL;
+                size_t chunk_count = 0;
+                double comp_ms = 0.0, decomp_ms = 0.0;
+                if (compress_multi(data, size, block_size, threads, level, 0, 0, 0,
+                                   &chunks, &chunk_count, &comp_ms, NULL) != LZO_E_OK) {
+                    ok = 0;
+                    break;
+                }
+                for (size_t i = 0; i < chunk_count; ++i)
+                    chunks[i].out = out + chunks[i].offset;
+                ok = decompress_multi(chunks, chunk_count, threads, 0, 0, &decomp_ms) == LZO_E_OK &&
+                     memcmp(out, data, size) == 0;
+                free_compression_chunks(chunks, chunk_count);
+                if (r == 0 || comp_ms < best_c) best_c = comp_ms;
+                if (r == 0 || decomp_ms < best_d) best_d = decomp_ms;
+            }
+            if (!ok) {
+                fprintf(stderr, "  %s: FAIL", sched_names[s]);
+                continue;
+            }
+            fprintf(stderr, "  %s: comp=%.3fms(%.2fMB/s) decomp=%.3fms(%.2fMB/s)",
+                    sched_names[s],
+                    best_c, best_c > 0.0 ? (size / 1048576.0) / (best_c / 1000.0) : 0.0,
+                    best_d, best_d > 0.0 ? (size / 1048576.0) / (best_d / 1000.0) : 0.0);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    g_sched = saved;
+    free(out);
+}
+
+/* Adaptive block sizing. Compress ADAPT_SAMPLES windows spread over the
+ * input and look at how much the per-byte cost varies between them: the
+ * more uneven it is (e.g. compressible text next to incompressible media),
+ * the more blocks each thread gets so that the tail of the job balances
+ * out. Blocks never drop below what takes ADAPT_MIN_BLOCK_US to compress,
+ * which keeps scheduling and per-block header overhead negligible. The
+ * decision is summarised in `reason` for the stats line.
+ */
+static size_t choose_block_size_adaptive(const unsigned char *data, size_t size, int threads,
+                                         alg_t alg, char *reason, size_t reason_len) {
+    if (threads < 1) threads = 1;
+    size_t even = choose_block_size(size, threads);
+    if (size < (size_t)ADAPT_SAMPLES * ADAPT_SAMPLE_SIZE) {
+        snprintf(reason, reason_len, "adaptive:small-input");
+        return even;
+    }
+
+    size_t cap = ADAPT_SAMPLE_SIZE + ADAPT_SAMPLE_SIZE / 16u + 64u + 3u;
+    unsigned char *out = (unsigned char *)malloc(cap);
+    void *wrkmem = NULL;
+    if (!out || posix_memalign(&wrkmem, sizeof(lzo_align_t), LZO_WORK_MEM_SIZE) != 0) {
+        free(out);
+        snprintf(reason, reason_len, "adaptive:no-memory");
+        return even;
+    }
+
+    double cost_min = 0.0, cost_max = 0.0, cost_sum = 0.0;
+    double ratio_min = 0.0, ratio_max = 0.0;
+    size_t out_len = 0;
+    /* warm-up so the first timed window does not pay for cold caches */
+    compress_block_into(data, ADAPT_SAMPLE_SIZE, 0, out, cap, &out_len, alg, wrkmem);
+    for (size_t i = 0; i < ADAPT_SAMPLES; ++i) {
+        size_t off = (size - ADAPT_SAMPLE_SIZE) / (ADAPT_SAMPLES - 1u) * i;
+        double cost = 0.0;    /* ns per byte, best of two runs to damp timer noise */
+        for (int run = 0; run < 2; ++run) {
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            compress_block_into(data + off, ADAPT_SAMPLE_SIZE, 0, out, cap, &out_len, alg, wrkmem);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            double c = diff_ms_ts(&t0, &t1) * 1e6 / ADAPT_SAMPLE_SIZE;
+            if (run == 0 || c < cost) cost = c;
+        }
+        double ratio = (double)out_len / ADAPT_SAMPLE_SIZE;
+        if (i == 0 || cost < cost_min) cost_min = cost;
+        if (i == 0 || cost > cost_max) cost_max = cost;
+        if (i == 0 || ratio < ratio_min) ratio_min = ratio;
+        if (i == 0 || ratio > ratio_max) ratio_max = ratio;
+        cost_sum += cost;
+    }
+    free(wrkmem);
+    free(out);
+
+    double cost_mean = cost_sum / ADAPT_SAMPLES;
+    double spread = cost_mean > 0.0 ? (cost_max - cost_min) / cost_mean : 0.0;
+    size_t per_thread = spread < 0.25 ? 2u : spread < 1.0 ? 8u : 16u;
+    size_t blk = size / ((size_t)threads * per_thread);
+    const char *limit = "";
+
+    size_t min_blk = cost_mean > 0.0 ? (size_t)(ADAPT_MIN_BLOCK_US * 1000.0 / cost_mean) : 0u;
+    if (blk < min_blk) {
+        blk = min_blk;
+        limit = ",min-time";
+    }
+    if (blk < MIN_BLOCK_SIZE) {
+        blk = MIN_BLOCK_SIZE;
+        limit = ",min-size";
+    }
+    if (blk > MAX_BLOCK_SIZE) {
+        blk = MAX_BLOCK_SIZE;
+        limit = ",max-size";
+    }
+    blk = (blk + 4095u) & ~(size_t)4095u;
+    if (blk > MAX_BLOCK_SIZE) blk = MAX_BLOCK_SIZE;
+    if (blk > size) blk = size;
+
+    snprintf(reason, reason_len, "adaptive:spread=%.2f,ratio=%.2f-%.2f,%zu/thread%s",
+             spread, ratio_min, ratio_max, per_thread, limit);
+    return blk;
+}
+
 static int compress_file(const char *input_path, const char *output_path,
-                         int level, int threads, int do_bench, int verify_only) {
+                         int level, int threads, int do_bench, int verify_only,
+                         int format, unsigned flags, size_t block_req) {
     struct timespec t_total_start, t_total_end;
     clock_gettime(CLOCK_MONOTONIC, &t_total_start);
 
     struct timespec t_read_start, t_read_end;
     clock_gettime(CLOCK_MONOTONIC, &t_read_start);
 
-    size_t input_size = 0;
-    unsigned char *input = read_entire(input_path, &input_size);
-    if (!input && input_size != 0) return 1;
+    file_map_t in_map;
+    if (map_input(input_path, &in_map) != 0) return 1;
+    const unsigned char *input = in_map.data;
+    size_t input_size = in_map.size;
 
     clock_gettime(CLOCK_MONOTONIC, &t_read_end);
     double read_ms = diff_ms_ts(&t_read_start, &t_read_end);
 
-    if (input_size > UINT32_MAX) {
-        fprintf(stderr, "input larger than 4 GiB is not supported\n");
-        free(input);
-        return 1;
+    /* the v1 header stores 32-bit sizes; larger inputs need v2 */
+    if (format != 2 && (uint64_t)input_size > UINT32_MAX)
+        format = 2;
+    if (flags) format = 2;
+
+    char sizing[96] = "even";
+    size_t block_size;
+    if (block_req == BLOCK_SIZE_AUTO) {
+        alg_t use_alg = (g_alg != ALG_NONE) ? g_alg : alg_from_level(level);
+        block_size = choose_block_size_adaptive(input, input_size, threads, use_alg,
+                                                sizing, sizeof(sizing));
+    } else if (block_req != 0) {
+        block_size = input_size < block_req ? input_size : block_req;
+        strcpy(sizing, "fixed");
+    } else {
+        block_size = choose_block_size(input_size, threads);
     }
-
-    size_t block_size = choose_block_size(input_size, threads);
     chunk_t *chunks = NULL;
     size_t chunk_count = 0;
     double comp_ms = 0.0;
     size_t total_comp = 0;
-    int rc = compress_multi(input, input_size, block_size, threads, level,
-                            &chunks, &chunk_count, &comp_ms, &total_comp);
+    /* v1 has no way to mark a block stored, so only v2 output probes */
+    int rc = compress_multi(input, input_size, block_size, threads, level, format == 2,
+                            flags & CONTAINER_FLAG_CHECKSUM, (flags & CONTAINER_FLAG_CHAINED) != 0, &chunks, &chunk_count, &comp_ms, &total_comp);
     if (rc != LZO_E_OK) {
         fprintf(stderr, "compress failed: %d\n", rc);
-        free(input);
+        release_map(&in_map);
         return 1;
     }
 
@@ -652,28 +1254,47 @@ static int compress_file(const char *input_path, const char *output_path,
     double write_ms = 0.0;
     clock_gettime(CLOCK_MONOTONIC, &t_prepare_start);
 
-    size_t header_size = 2u + 4u + 4u + 4u + chunk_count * 4u;
-    size_t total_size = header_size + total_comp;
-    unsigned char *out_buf = (unsigned char *)malloc(total_size ? total_size : 1u);
+    /* Only the header and tables are assembled here; the payload is written
+     * from the chunk buffers in place by write_chunks(). */
+    size_t stored_count = 0;
+    for (size_t i = 0; i < chunk_count; ++i)
+        stored_count += chunks[i].stored != 0;
+    if (stored_count) flags |= CONTAINER_FLAG_STORED;
+    size_t header_size = container_header_size(format, flags, chunk_count);
+    unsigned char *out_buf = (unsigned char *)malloc(header_size);
     if (!out_buf) {
         fprintf(stderr, "malloc failed\n");
-        free(input);
+        release_map(&in_map);
         free_compression_chunks(chunks, chunk_count);
         return 1;
     }
 
-    size_t cursor = 0;
-    write_u16(out_buf + cursor, MAGIC_TAG); cursor += 2u;
-    write_u32(out_buf + cursor, (uint32_t)input_size); cursor += 4u;
-    write_u32(out_buf + cursor, (uint32_t)block_size); cursor += 4u;
-    write_u32(out_buf + cursor, (uint32_t)chunk_count); cursor += 4u;
+    size_t cursor = write_container_header(out_buf, format, flags, input_size, block_size, chunk_count);
     for (size_t i = 0; i < chunk_count; ++i) {
-        write_u32(out_buf + cursor, (uint32_t)chunks[i].comp_size);
+        write_u32(out_buf + cursor, (uint32_t)chunks[i].comp_size | (chunks[i].stored ? BLOCK_STORED_BIT : 0u));
         cursor += 4u;
     }
-    for (size_t i = 0; i < chunk_count; ++i) {
-        memcpy(out_buf + cursor, chunks[i].comp, chunks[i].comp_size);
-        cursor += chunks[i].comp_size;
+    if (flags & CONTAINER_FLAG_INDEX) {
+        uint64_t pos = 0;
+        for (size_t i = 0; i <= chunk_count; ++i) {
+            write_u64(out_buf + cursor, pos);
+            cursor += 8u;
+            if (i < chunk_count) pos += chunks[i].comp_size;
+        }
+    }
+    if (flags & CONTAINER_FLAG_CHECKSUM) {
+        uint32_t whole = lzo_index_checksum(flags, NULL, 0);
+        for (size_t i = 0; i < chunk_count; ++i) {
+            write_u32(out_buf + cursor, chunks[i].sum);
+            cursor += 4u;
+            whole = lzo_index_checksum_combine(flags, whole, chunks[i].sum, chunks[i].in_size);
+        }
+        write_u32(out_buf + cursor, whole);
+        cursor += 4u;
+    }
+    if (flags & CONTAINER_FLAG_DICT) {
+        write_u32(out_buf + cursor, g_dict_sum);
+        cursor += 4u;
     }
 
     if (verify_only) {
@@ -682,19 +1303,20 @@ static int compress_file(const char *input_path, const char *output_path,
         if (!multi_out) {
             fprintf(stderr, "malloc failed\n");
             free(out_buf);
-            free(input);
+            release_map(&in_map);
             free_compression_chunks(chunks, chunk_count);
             return 1;
         }
         for (size_t i = 0; i < chunk_count; ++i)
             chunks[i].out = multi_out + chunks[i].offset;
         double multi_decomp_ms = 0.0;
-        int rc = decompress_multi(chunks, chunk_count, threads, &multi_decomp_ms);
+        int rc = decompress_multi(chunks, chunk_count, threads, flags & CONTAINER_FLAG_CHECKSUM,
+                                  (flags & CONTAINER_FLAG_CHAINED) != 0, &multi_decomp_ms);
         if (rc != LZO_E_OK) {
             fprintf(stderr, "verify decompress failed: %d\n", rc);
             free(multi_out);
             free(out_buf);
-            free(input);
+            release_map(&in_map);
             free_compression_chunks(chunks, chunk_count);
             return 1;
         }
@@ -702,7 +1324,7 @@ static int compress_file(const char *input_path, const char *output_path,
             fprintf(stderr, "verify failed: decompressed data differs\n");
             free(multi_out);
             free(out_buf);
-            free(input);
+            release_map(&in_map);
             free_compression_chunks(chunks, chunk_count);
             return 1;
         }
@@ -714,10 +1336,10 @@ static int compress_file(const char *input_path, const char *output_path,
     } else {
         clock_gettime(CLOCK_MONOTONIC, &t_write_start);
 
-        if (write_entire(output_path, out_buf, total_size) != 0) {
+        if (write_chunks(output_path, out_buf, header_size, chunks, chunk_count) != 0) {
             fprintf(stderr, "failed to write output\n");
             free(out_buf);
-            free(input);
+            release_map(&in_map);
             free_compression_chunks(chunks, chunk_count);
             return 1;
         }
@@ -745,24 +1367,28 @@ static int compress_file(const char *input_path, const char *output_path,
 
         if (verify_only) {
             fprintf(stderr,
-                    "Compressed %zu bytes -> %zu bytes (%.2f%%) blocks=%zu block_sz=%zu threads=%d alg=%s time=%.3f ms (%.2f MB/s)\n",
+                    "Compressed %zu bytes -> %zu bytes (%.2f%%) blocks=%zu stored=%zu block_sz=%zu sizing=%s threads=%d alg=%s time=%.3f ms (%.2f MB/s)\n",
                     input_size,
                     total_comp,
                     input_size ? (100.0 * total_comp / input_size) : 0.0,
                     chunk_count,
+                    stored_count,
                     block_size,
+                    sizing,
                     threads,
                     alg_to_str(used_alg),
                     comp_ms,
                     comp_ms > 0.0 ? (input_size / 1048576.0) / (comp_ms / 1000.0) : 0.0);
         } else {
             fprintf(stderr,
-                    "Compressed %zu bytes -> %zu bytes (%.2f%%) blocks=%zu block_sz=%zu threads=%d alg=%s\n",
+                    "Compressed %zu bytes -> %zu bytes (%.2f%%) blocks=%zu stored=%zu block_sz=%zu sizing=%s threads=%d alg=%s\n",
                     input_size,
                     total_comp,
                     input_size ? (100.0 * total_comp / input_size) : 0.0,
                     chunk_count,
+                    stored_count,
                     block_size,
+                    sizing,
                     threads,
                     alg_to_str(used_alg));
             fprintf(stderr,
@@ -779,101 +1405,268 @@ static int compress_file(const char *input_path, const char *output_path,
     if (do_bench) run_benchmark(input, input_size, level, threads);
 
     free(out_buf);
-    free(input);
+    release_map(&in_map);
     free_compression_chunks(chunks, chunk_count);
     return 0;
 }
 
-static int decompress_file(const char *input_path, const char *output_path,
-                           int threads, int verify_only) {
-    size_t comp_size = 0;
-    unsigned char *comp = read_entire(input_path, &comp_size);
-    if (!comp && comp_size != 0) return 1;
+/* Parse a container held entirely in memory. The indexed layouts
+ * (MAGIC_TAG, MAGIC_TAG_V2) and the framed streaming layout
+ * (STREAM_MAGIC_TAG) are accepted. On success *chunks_out holds one entry per block with comp,
+ * comp_size, in_size and offset filled in; the caller points chunks[i].out
+ * into its output buffer. With a checksum table, chunks[i].sum and
+ * *sum_out (the whole-input checksum) are filled in as well and
+ * *flags_out tells which algorithm they use. A chained container also sets
+ * chunks[i].hist and CONTAINER_FLAG_CHAINED in *flags_out. The container
+ * is rejected unless --dict matches its dictionary, see check_dict().
+ */
+static int parse_container(const unsigned char *comp, size_t comp_size,
+                           chunk_t **chunks_out, size_t *nblk_out,
+                           size_t *orig_size_out, size_t *blk_size_out,
+                           size_t *total_comp_out, unsigned *flags_out,
+                           uint32_t *sum_out) {
+    *chunks_out = NULL;
+    *nblk_out = 0;
+    *flags_out = 0;
+
+    if (comp_size >= 6u && read_u16(comp) == STREAM_MAGIC_TAG) {
+        if (check_dict(0u, 0u) != 0) return -1;
+        size_t blk_sz = read_u32(comp + 2u);
+        size_t nblk = 0, cursor = 6u;
+        int terminated = 0;
+        /* first pass: validate frames and count blocks */
+        while (cursor + 4u <= comp_size) {
+            size_t raw_len = read_u32(comp + cursor);
+            if (raw_len == 0) {
+                terminated = 1;
+                break;
+            }
+            if (cursor + 8u > comp_size) break;
+            uint32_t word = read_u32(comp + cursor + 4u);
+            size_t clen = word & ~BLOCK_STORED_BIT;
+            if (raw_len > blk_sz || clen > comp_size - cursor - 8u) break;
+            if ((word & BLOCK_STORED_BIT) && clen != raw_len) break;
+            cursor += 8u + clen;
+            ++nblk;
+        }
+        if (!terminated) {
+            fprintf(stderr, "truncated stream\n");
+            return -1;
+        }
 
-    if (comp_size < 14u) {
+        chunk_t *chunks = NULL;
+        if (nblk > 0) {
+            chunks = (chunk_t *)calloc(nblk, sizeof(chunk_t));
+            if (!chunks) {
+                fprintf(stderr, "calloc failed\n");
+                return -1;
+            }
+        }
+        size_t offset = 0, total_comp = 0;
+        cursor = 6u;
+        for (size_t i = 0; i < nblk; ++i) {
+            size_t raw_len = read_u32(comp + cursor);
+            uint32_t word = read_u32(comp + cursor + 4u);
+            size_t clen = word & ~BLOCK_STORED_BIT;
+            chunks[i].comp = (unsigned char *)(comp + cursor + 8u);
+            chunks[i].comp_size = clen;
+            chunks[i].stored = (word & BLOCK_STORED_BIT) != 0;
+            chunks[i].in_size = raw_len;
+            chunks[i].offset = offset;
+            offset += raw_len;
+            total_comp += clen;
+            cursor += 8u + clen;
+        }
+        *chunks_out = chunks;
+        *nblk_out = nblk;
+        *orig_size_out = offset;
+        *blk_size_out = blk_sz;
+        *total_comp_out = total_comp;
+        return 0;
+    }
+
+    if (comp_size < HEADER_SIZE_V1) {
         fprintf(stderr, "input too small\n");
-        free(comp);
-        return 1;
+        return -1;
     }
 
-    size_t cursor = 0;
-    uint16_t magic = read_u16(comp + cursor); cursor += 2u;
-    if (magic != MAGIC_TAG) {
+    size_t cursor;
+    uint64_t orig_sz, nblk;
+    size_t blk_sz;
+    unsigned flags = 0;
+    uint16_t magic = read_u16(comp);
+    if (magic == MAGIC_TAG) {
+        orig_sz = read_u32(comp + 2u);
+        blk_sz = read_u32(comp + 6u);
+        nblk = read_u32(comp + 10u);
+        cursor = HEADER_SIZE_V1;
+    } else if (magic == MAGIC_TAG_V2) {
+        if (comp_size < HEADER_SIZE_V2) {
+            fprintf(stderr, "input too small\n");
+            return -1;
+        }
+        if (comp[2] != CONTAINER_VERSION) {
+            fprintf(stderr, "unsupported container version %u\n", (unsigned)comp[2]);
+            return -1;
+        }
+        flags = comp[3];
+        orig_sz = read_u64(comp + 4u);
+        blk_sz = read_u32(comp + 12u);
+        nblk = read_u64(comp + 16u);
+        cursor = HEADER_SIZE_V2;
+    } else {
         fprintf(stderr, "bad magic 0x%04x\n", magic);
-        free(comp);
-        return 1;
+        return -1;
     }
-    uint32_t orig_sz = read_u32(comp + cursor); cursor += 4u;
-    uint32_t blk_sz = read_u32(comp + cursor); cursor += 4u;
-    uint32_t nblk = read_u32(comp + cursor); cursor += 4u;
 
-    size_t lengths_bytes = (size_t)nblk * 4u;
-    if (cursor + lengths_bytes > comp_size) {
+    if (nblk > (comp_size - cursor) / 4u) {
         fprintf(stderr, "truncated length table\n");
-        free(comp);
-        return 1;
+        return -1;
+    }
+    /* every block but the last holds blk_sz bytes; the last takes the rest */
+    if (orig_sz > SIZE_MAX ||
+        (nblk > 0 && blk_sz != 0 && nblk - 1u > orig_sz / blk_sz)) {
+        fprintf(stderr, "inconsistent container header\n");
+        return -1;
     }
+    size_t lengths_bytes = (size_t)nblk * 4u;
 
     const unsigned char *lengths_ptr = comp + cursor;
     cursor += lengths_bytes;
+    if (flags & CONTAINER_FLAG_INDEX) {
+        /* stored offsets are only needed for random access */
+        if ((comp_size - cursor) / 8u < (size_t)nblk + 1u) {
+            fprintf(stderr, "truncated offset index\n");
+            return -1;
+        }
+        cursor += ((size_t)nblk + 1u) * 8u;
+    }
+    const unsigned char *sums_ptr = NULL;
+    if (flags & CONTAINER_FLAG_CHECKSUM) {
+        if ((comp_size - cursor) / 4u < (size_t)nblk + 1u) {
+            fprintf(stderr, "truncated checksum table\n");
+            return -1;
+        }
+        sums_ptr = comp + cursor;
+        cursor += ((size_t)nblk + 1u) * 4u;
+    }
+    uint32_t dict_sum = 0;
+    if (flags & CONTAINER_FLAG_DICT) {
+        if (comp_size - cursor < 4u) {
+            fprintf(stderr, "truncated dictionary checksum\n");
+            return -1;
+        }
+        dict_sum = read_u32(comp + cursor);
+        cursor += 4u;
+    }
+    if (check_dict(flags, dict_sum) != 0) return -1;
     const unsigned char *payload = comp + cursor;
     size_t payload_size = comp_size - cursor;
 
+    /* bit 31 of a length marks a stored block only in containers flagged so */
+    uint32_t len_mask = (flags & CONTAINER_FLAG_STORED) ? ~BLOCK_STORED_BIT : ~0u;
     size_t total_comp = 0;
-    for (uint32_t i = 0; i < nblk; ++i)
-        total_comp += read_u32(lengths_ptr + i * 4u);
+    for (size_t i = 0; i < nblk; ++i)
+        total_comp += read_u32(lengths_ptr + i * 4u) & len_mask;
     if (total_comp > payload_size) {
         fprintf(stderr, "truncated payload\n");
-        free(comp);
-        return 1;
-    }
-
-    size_t output_size = orig_sz;
-    unsigned char *output = (unsigned char *)malloc(output_size ? output_size : 1u);
-    if (!output && output_size != 0) {
-        fprintf(stderr, "malloc failed\n");
-        free(comp);
-        return 1;
+        return -1;
     }
 
     chunk_t *chunks = NULL;
     if (nblk > 0) {
-        chunks = (chunk_t *)calloc(nblk, sizeof(chunk_t));
+        chunks = (chunk_t *)calloc((size_t)nblk, sizeof(chunk_t));
         if (!chunks) {
             fprintf(stderr, "calloc failed\n");
-            free(output);
-            free(comp);
-            return 1;
+            return -1;
         }
 
         const unsigned char *blk_ptr = payload;
         size_t offset = 0;
-        for (uint32_t i = 0; i < nblk; ++i) {
-            uint32_t clen = read_u32(lengths_ptr + i * 4u);
-            size_t orig_chunk = (i == nblk - 1u) ? (size_t)orig_sz - offset : (size_t)blk_sz;
+        for (size_t i = 0; i < nblk; ++i) {
+            uint32_t word = read_u32(lengths_ptr + i * 4u);
+            uint32_t clen = word & len_mask;
+            int stored = (word & ~len_mask) != 0;
+            size_t orig_chunk = (i == nblk - 1u) ? (size_t)orig_sz - offset : blk_sz;
             if (blk_ptr + clen > payload + payload_size) {
                 fprintf(stderr, "chunk overflow\n");
-                free(output);
-                free(comp);
                 free(chunks);
-                return 1;
+                return -1;
+            }
+            if (stored && clen != orig_chunk) {
+                fprintf(stderr, "bad stored block length\n");
+                free(chunks);
+                return -1;
             }
             chunks[i].comp = (unsigned char *)blk_ptr;
             chunks[i].comp_size = clen;
+            chunks[i].stored = stored;
+            if (sums_ptr) chunks[i].sum = read_u32(sums_ptr + i * 4u);
             chunks[i].in_size = orig_chunk;
             chunks[i].offset = offset;
-            chunks[i].out = output + offset;
+            if (flags & CONTAINER_FLAG_CHAINED)
+                chunks[i].hist = offset < CHAIN_WINDOW ? offset : CHAIN_WINDOW;
             blk_ptr += clen;
             offset += orig_chunk;
         }
     }
 
+    *chunks_out = chunks;
+    *nblk_out = (size_t)nblk;
+    *orig_size_out = (size_t)orig_sz;
+    *blk_size_out = blk_sz;
+    *total_comp_out = total_comp;
+    *flags_out = flags & CONTAINER_FLAG_CHAINED;
+    if (sums_ptr) {
+        *flags_out |= flags & CONTAINER_FLAG_CHECKSUM;
+        *sum_out = read_u32(sums_ptr + (size_t)nblk * 4u);
+    }
+    return 0;
+}
+
+static int decompress_file(const char *input_path, const char *output_path,
+                           int threads, int verify_only) {
+    file_map_t in_map;
+    if (map_input(input_path, &in_map) != 0) return 1;
+
+    chunk_t *chunks = NULL;
+    size_t nblk = 0, orig_sz = 0, blk_sz = 0, total_comp = 0;
+    unsigned flags = 0;
+    uint32_t whole_sum = 0;
+    if (parse_container(in_map.data, in_map.size, &chunks, &nblk, &orig_sz, &blk_sz, &total_comp,
+                        &flags, &whole_sum) != 0) {
+        release_map(&in_map);
+        return 1;
+    }
+    unsigned checksum = flags & CONTAINER_FLAG_CHECKSUM;
+
+    /* workers decompress straight into the (mapped) output file */
+    file_map_t out_map;
+    if (map_output(verify_only ? NULL : output_path, orig_sz, &out_map) != 0) {
+        free(chunks);
+        release_map(&in_map);
+        return 1;
+    }
+    for (size_t i = 0; i < nblk; ++i)
+        chunks[i].out = out_map.data + chunks[i].offset;
+
     double decomp_ms = 0.0;
-    int rc = decompress_multi(chunks, nblk, threads, &decomp_ms);
+    int rc = decompress_multi(chunks, nblk, threads, checksum,
+                              (flags & CONTAINER_FLAG_CHAINED) != 0, &decomp_ms);
+    if (rc == LZO_E_OK && checksum) {
+        /* every block matched its sum; the table must also add up */
+        uint32_t whole = lzo_index_checksum(checksum, NULL, 0);
+        for (size_t i = 0; i < nblk; ++i)
+            whole = lzo_index_checksum_combine(checksum, whole, chunks[i].sum, chunks[i].in_size);
+        if (whole != whole_sum) {
+            fprintf(stderr, "checksum mismatch for the whole input\n");
+            rc = LZO_E_ERROR;
+        }
+    }
     if (rc != LZO_E_OK) {
         fprintf(stderr, "decompress failed: %d\n", rc);
-        free(output);
-        free(comp);
+        abort_output(output_path, &out_map);
+        release_map(&in_map);
         free(chunks);
         return 1;
     }
@@ -881,7 +1674,7 @@ static int decompress_file(const char *input_path, const char *output_path,
     if (verify_only) {
         /* Don't write output; just report verification via successful decompression */
         fprintf(stderr,
-                "Verify decompress OK: compressed=%zu decompressed=%u (blocks=%u block_sz=%u threads=%d time=%.3f ms %.2f MB/s)\n",
+                "Verify decompress OK: compressed=%zu decompressed=%zu (blocks=%zu block_sz=%zu threads=%d time=%.3f ms %.2f MB/s)\n",
                 total_comp,
                 orig_sz,
                 nblk,
@@ -889,17 +1682,17 @@ static int decompress_file(const char *input_path, const char *output_path,
                 threads,
                 decomp_ms,
                 decomp_ms > 0.0 ? (orig_sz / 1048576.0) / (decomp_ms / 1000.0) : 0.0);
+        release_map(&out_map);
     } else {
-        if (write_entire(output_path, output, output_size) != 0) {
+        if (finish_output(output_path, &out_map) != 0) {
             fprintf(stderr, "failed to write output\n");
-            free(output);
-            free(comp);
+            release_map(&in_map);
             free(chunks);
             return 1;
         }
 
         fprintf(stderr,
-                "Decompressed %zu bytes -> %u bytes (blocks=%u block_sz=%u threads=%d time=%.3f ms %.2f MB/s)\n",
+                "Decompressed %zu bytes -> %zu bytes (blocks=%zu block_sz=%zu threads=%d time=%.3f ms %.2f MB/s)\n",
                 total_comp,
                 orig_sz,
                 nblk,
@@ -909,12 +1702,617 @@ static int decompress_file(const char *input_path, const char *output_path,
                 decomp_ms > 0.0 ? (orig_sz / 1048576.0) / (decomp_ms / 1000.0) : 0.0);
     }
 
-    free(output);
-    free(comp);
+    release_map(&in_map);
     free(chunks);
     return 0;
 }
 
+/* Decompress only the original bytes [off, off + len) through the block
+ * index; blocks outside the range are never read from the file.
+ */
+static int decompress_range(const char *input_path, const char *output_path,
+                            uint64_t off, uint64_t len) {
+    if (strcmp(input_path, "-") == 0) {
+        fprintf(stderr, "--range needs a seekable input file\n");
+        return 1;
+    }
+    FILE *fp = fopen(input_path, "rb");
+    if (!fp) {
+        perror(input_path);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    lzo_index_t idx;
+    if (lzo_index_open(fp, &idx) != 0) {
+        fclose(fp);
+        return 1;
+    }
+    if (check_dict(idx.flags, idx.dict_sum) != 0) {
+        lzo_index_close(&idx);
+        fclose(fp);
+        return 1;
+    }
+    idx.dict = g_dict;
+    idx.dict_len = g_dict_len;
+    size_t first, last;
+    if (len > SIZE_MAX || lzo_index_block_range(&idx, off, len, &first, &last) != 0) {
+        fprintf(stderr, "range %llu:%llu is outside the %llu byte input\n",
+                (unsigned long long)off, (unsigned long long)len,
+                (unsigned long long)idx.orig_size);
+        lzo_index_close(&idx);
+        fclose(fp);
+        return 1;
+    }
+
+    unsigned char *out = (unsigned char *)malloc((size_t)len);
+    if (!out) {
+        fprintf(stderr, "malloc failed\n");
+        lzo_index_close(&idx);
+        fclose(fp);
+        return 1;
+    }
+    int rc = lzo_index_read_range(fp, &idx, off, len, out);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    lzo_index_close(&idx);
+    fclose(fp);
+    if (rc != LZO_E_OK) {
+        fprintf(stderr, "range decompress failed: %d\n", rc);
+        free(out);
+        return 1;
+    }
+
+    if (write_entire(output_path, out, (size_t)len) != 0) {
+        fprintf(stderr, "failed to write output\n");
+        free(out);
+        return 1;
+    }
+    fprintf(stderr,
+            "Range %llu:%llu -> blocks=%zu-%zu of %zu block_sz=%zu index=%s time=%.3f ms\n",
+            (unsigned long long)off, (unsigned long long)len, first, last, idx.nblk,
+            idx.blk_size, idx.index_pos ? "stored" : "computed", diff_ms_ts(&t0, &t1));
+    free(out);
+    return 0;
+}
+
+/* Streaming pipeline: a reader stage (the calling thread), a pool of
+ * block workers and an in-order writer stage share a ring of block slots.
+ * Memory use is bounded by the ring size regardless of the input length,
+ * and reading, compression and writing overlap.
+ *
+ * For regular files the reader and writer go through lzo_aio: the reader
+ * keeps a block-sized read in flight for every free slot (compression
+ * only, since compressed frames are variable-length) and the writer
+ * queues each finished block at its output offset, releasing the slot on
+ * completion. Pipes and --io sync use blocking stdio.
+ *
+ * Stream layout (STREAM_MAGIC_TAG):
+ *   u16 magic, u32 blk_size,
+ *   repeated { u32 raw_len, u32 comp_len, comp_len bytes },
+ *   u32 0 terminator.
+ * A comp_len with BLOCK_STORED_BIT set is followed by the raw_len original
+ * bytes instead of LZO1X data.
+ */
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_READING,
+    SLOT_FILLED,
+    SLOT_BUSY,
+    SLOT_DONE,
+} slot_state_t;
+
+#define STREAM_FRAME_HDR 8u
+
+typedef struct {
+    unsigned char *raw;
+    size_t raw_len;
+    unsigned char *frame;   /* STREAM_FRAME_HDR bytes, then comp */
+    unsigned char *comp;
+    size_t comp_len;
+    int stored;             /* comp holds the raw bytes */
+    size_t io_len;          /* length of the queued asynchronous write */
+    size_t seq;
+    slot_state_t state;
+} stream_slot_t;
+
+typedef struct {
+    stream_slot_t *slots;
+    size_t slot_count;
+    size_t block_size;
+    int decompress;
+    alg_t compression_alg;
+    FILE *in;
+    FILE *out;
+    lzo_aio_t *rd_aio;   /* read-ahead queue, NULL for stdio reads */
+    lzo_aio_t *wr_aio;   /* write-behind queue, NULL for stdio writes */
+    int in_fd;
+    int out_fd;
+    uint64_t in_size;    /* input length when reading through rd_aio */
+    uint64_t out_pos;    /* next output offset when writing through wr_aio */
+    size_t next_read;    /* next sequence number the reader fills */
+    size_t next_work;    /* next sequence number a worker picks up */
+    int eof;             /* reader finished; next_read is the block count */
+    int status;
+    size_t total_in;
+    size_t total_out;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} stream_pipe_t;
+
+static size_t read_full(FILE *fp, unsigned char *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        size_t n = fread(buf + got, 1u, len - got, fp);
+        if (n == 0) break;
+        got += n;
+    }
+    return got;
+}
+
+static void stream_fail(stream_pipe_t *p, int rc) {
+    pthread_mutex_lock(&p->lock);
+    if (p->status == LZO_E_OK) p->status = rc;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* Runs as one pool task per thread and loops until the reader hits EOF. */
+static int stream_worker(void *opaque, size_t idx, void *wrkmem) {
+    stream_pipe_t *p = (stream_pipe_t *)opaque;
+    (void)idx;
+
+    while (1) {
+        pthread_mutex_lock(&p->lock);
+        while (p->status == LZO_E_OK && p->next_work >= p->next_read && !p->eof)
+            pthread_cond_wait(&p->cond, &p->lock);
+        if (p->status != LZO_E_OK || p->next_work >= p->next_read) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        stream_slot_t *slot = &p->slots[p->next_work % p->slot_count];
+        p->next_work++;
+        slot->state = SLOT_BUSY;
+        pthread_mutex_unlock(&p->lock);
+
+        int rc;
+        if (p->decompress) {
+            if (slot->stored) {
+                memcpy(slot->raw, slot->comp, slot->raw_len);
+                rc = LZO_E_OK;
+            } else {
+                rc = decompress_block(slot->comp, slot->comp_len, slot->raw, slot->raw_len, 0);
+            }
+        } else {
+            size_t cap = slot->raw_len + slot->raw_len / 16u + 64u + 3u;
+            rc = compress_or_store(slot->raw, slot->raw_len, 0, slot->comp, cap, &slot->comp_len,
+                                   &slot->stored, p->compression_alg, wrkmem);
+            /* the frame must be contiguous for a single write */
+            if (rc == LZO_E_OK && slot->stored)
+                memcpy(slot->comp, slot->raw, slot->raw_len);
+        }
+        if (rc != LZO_E_OK) {
+            stream_fail(p, rc);
+            break;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        slot->state = SLOT_DONE;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+    return LZO_E_OK;
+}
+
+/* Return a written slot to the reader. */
+static void stream_release(stream_pipe_t *p, stream_slot_t *slot) {
+    pthread_mutex_lock(&p->lock);
+    p->total_in += p->decompress ? slot->comp_len : slot->raw_len;
+    p->total_out += p->decompress ? slot->raw_len : slot->comp_len;
+    slot->state = SLOT_FREE;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* Wait for one queued write and release its slot. */
+static int stream_reap_write(stream_pipe_t *p) {
+    lzo_aio_event_t ev;
+    if (lzo_aio_wait(p->wr_aio, &ev) != 0) return -1;
+    stream_slot_t *slot = (stream_slot_t *)ev.tag;
+    if (ev.res < 0 || (size_t)ev.res != slot->io_len) return -1;
+    stream_release(p, slot);
+    return 0;
+}
+
+static void *stream_writer(void *opaque) {
+    stream_pipe_t *p = (stream_pipe_t *)opaque;
+    int io_error = 0;
+    for (size_t seq = 0; !io_error; ++seq) {
+        stream_slot_t *slot = &p->slots[seq % p->slot_count];
+        int ready = 0;
+        pthread_mutex_lock(&p->lock);
+        for (;;) {
+            if (p->status != LZO_E_OK) break;
+            if (slot->state == SLOT_DONE && slot->seq == seq) {
+                ready = 1;
+                break;
+            }
+            if (p->eof && seq >= p->next_read) break;
+            if (p->wr_aio && lzo_aio_inflight(p->wr_aio) > 0) {
+                /* completions free slots the reader may be waiting for */
+                pthread_mutex_unlock(&p->lock);
+                io_error = stream_reap_write(p) != 0;
+                pthread_mutex_lock(&p->lock);
+                if (io_error) break;
+                continue;
+            }
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        pthread_mutex_unlock(&p->lock);
+        if (!ready) break;
+
+        const unsigned char *buf;
+        if (p->decompress) {
+            buf = slot->raw;
+            slot->io_len = slot->raw_len;
+        } else {
+            write_u32(slot->frame, (uint32_t)slot->raw_len);
+            write_u32(slot->frame + 4u, (uint32_t)slot->comp_len | (slot->stored ? BLOCK_STORED_BIT : 0u));
+            buf = slot->frame;
+            slot->io_len = STREAM_FRAME_HDR + slot->comp_len;
+        }
+        if (p->wr_aio) {
+            if (lzo_aio_write(p->wr_aio, p->out_fd, buf, slot->io_len, p->out_pos, slot) != 0 ||
+                lzo_aio_submit(p->wr_aio) != 0) {
+                io_error = 1;
+                break;
+            }
+            p->out_pos += slot->io_len;
+        } else {
+            if (fwrite(buf, 1u, slot->io_len, p->out) != slot->io_len) {
+                io_error = 1;
+                break;
+            }
+            stream_release(p, slot);
+        }
+    }
+    while (p->wr_aio && lzo_aio_inflight(p->wr_aio) > 0)
+        if (stream_reap_write(p) != 0) io_error = 1;
+    if (io_error) {
+        fprintf(stderr, "short write\n");
+        stream_fail(p, LZO_E_ERROR);
+    }
+    return NULL;
+}
+
+/* Reader stage: fill the next free slot. Returns 1 when a block was queued,
+ * 0 at end of input and -1 on a read or format error.
+ */
+static int stream_read_block(stream_pipe_t *p, stream_slot_t *slot) {
+    if (!p->decompress) {
+        slot->raw_len = read_full(p->in, slot->raw, p->block_size);
+        if (ferror(p->in)) {
+            fprintf(stderr, "read error\n");
+            return -1;
+        }
+        return slot->raw_len > 0 ? 1 : 0;
+    }
+
+    unsigned char hdr[8];
+    if (read_full(p->in, hdr, 4u) != 4u) {
+        fprintf(stderr, "truncated stream\n");
+        return -1;
+    }
+    slot->raw_len = read_u32(hdr);
+    if (slot->raw_len == 0) return 0;
+    if (read_full(p->in, hdr + 4u, 4u) != 4u) {
+        fprintf(stderr, "truncated stream\n");
+        return -1;
+    }
+    uint32_t word = read_u32(hdr + 4u);
+    slot->comp_len = word & ~BLOCK_STORED_BIT;
+    slot->stored = (word & BLOCK_STORED_BIT) != 0;
+    size_t cap = p->block_size + p->block_size / 16u + 64u + 3u;
+    if (slot->raw_len > p->block_size || slot->comp_len > cap ||
+        (slot->stored && slot->comp_len != slot->raw_len)) {
+        fprintf(stderr, "corrupt stream frame\n");
+        return -1;
+    }
+    if (read_full(p->in, slot->comp, slot->comp_len) != slot->comp_len) {
+        fprintf(stderr, "truncated stream\n");
+        return -1;
+    }
+    return 1;
+}
+
+/* Reader stage over rd_aio: keep a read in flight for every free slot and
+ * publish blocks to the workers in sequence order as their reads land.
+ */
+static void stream_read_ahead(stream_pipe_t *p) {
+    size_t nblocks = (size_t)((p->in_size + p->block_size - 1u) / p->block_size);
+    size_t submitted = 0;
+    for (;;) {
+        size_t first = submitted;
+        pthread_mutex_lock(&p->lock);
+        if (p->status != LZO_E_OK) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        while (submitted < nblocks && p->slots[submitted % p->slot_count].state == SLOT_FREE) {
+            stream_slot_t *slot = &p->slots[submitted % p->slot_count];
+            slot->state = SLOT_READING;
+            slot->seq = submitted++;
+        }
+        if (submitted == first && lzo_aio_inflight(p->rd_aio) == 0) {
+            if (submitted == nblocks) {
+                p->eof = 1;
+                pthread_cond_broadcast(&p->cond);
+                pthread_mutex_unlock(&p->lock);
+                break;
+            }
+            pthread_cond_wait(&p->cond, &p->lock);
+            pthread_mutex_unlock(&p->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        int queued = 1;
+        for (size_t seq = first; seq < submitted && queued; ++seq) {
+            stream_slot_t *slot = &p->slots[seq % p->slot_count];
+            uint64_t off = (uint64_t)seq * p->block_size;
+            slot->raw_len = (size_t)(p->in_size - off < p->block_size ? p->in_size - off : p->block_size);
+            queued = lzo_aio_read(p->rd_aio, p->in_fd, slot->raw, slot->raw_len, off, slot) == 0;
+        }
+        lzo_aio_event_t ev;
+        if (!queued || lzo_aio_submit(p->rd_aio) != 0 || lzo_aio_wait(p->rd_aio, &ev) != 0) {
+            fprintf(stderr, "read error\n");
+            stream_fail(p, LZO_E_ERROR);
+            break;
+        }
+        stream_slot_t *slot = (stream_slot_t *)ev.tag;
+        if (ev.res < 0 || (size_t)ev.res != slot->raw_len) {
+            fprintf(stderr, ev.res < 0 ? "read error\n" : "input shrank while reading\n");
+            stream_fail(p, LZO_E_ERROR);
+            break;
+        }
+
+        pthread_mutex_lock(&p->lock);
+        slot->state = SLOT_FILLED;
+        while (p->next_read < submitted) {
+            stream_slot_t *s = &p->slots[p->next_read % p->slot_count];
+            if (s->state != SLOT_FILLED || s->seq != p->next_read) break;
+            p->next_read++;
+        }
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    /* slot buffers must outlive any read still in flight */
+    lzo_aio_event_t ev;
+    while (lzo_aio_inflight(p->rd_aio) > 0 && lzo_aio_wait(p->rd_aio, &ev) == 0)
+        ;
+}
+
+/* Backend label for the stats line: the write side, or the read side when
+ * only the input is a regular file. */
+static const char *stream_io_name(const stream_pipe_t *p) {
+    if (p->wr_aio) return lzo_aio_backend_name(p->wr_aio);
+    if (p->rd_aio) return lzo_aio_backend_name(p->rd_aio);
+    return "sync";
+}
+
+/* Regular files can be accessed by offset; pipes and terminals cannot. */
+static int is_regular_file(FILE *fp, uint64_t *size) {
+#ifndef _WIN32
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode)) {
+        if (size) *size = (uint64_t)st.st_size;
+        return 1;
+    }
+#else
+    (void)fp;
+    (void)size;
+#endif
+    return 0;
+}
+
+static int stream_file(const char *input_path, const char *output_path,
+                       int level, int threads, int decompress, int io_mode) {
+    if (threads < 1) threads = 1;
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    int from_stdin = strcmp(input_path, "-") == 0;
+    int to_stdout = strcmp(output_path, "-") == 0;
+#ifdef _WIN32
+    if (from_stdin) _setmode(_fileno(stdin), _O_BINARY);
+    if (to_stdout) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    FILE *in = from_stdin ? stdin : fopen(input_path, "rb");
+    if (!in) {
+        perror(input_path);
+        return 1;
+    }
+    FILE *out = to_stdout ? stdout : fopen(output_path, "wb");
+    if (!out) {
+        perror(output_path);
+        if (!from_stdin) fclose(in);
+        return 1;
+    }
+
+    stream_pipe_t p;
+    memset(&p, 0, sizeof(p));
+    p.decompress = decompress;
+    p.compression_alg = (g_alg != ALG_NONE) ? g_alg : alg_from_level(level);
+    p.in = in;
+    p.out = out;
+    p.in_fd = fileno(in);
+    p.out_fd = fileno(out);
+    p.status = LZO_E_OK;
+    p.block_size = STREAM_BLOCK_SIZE;
+
+    int rc = 1;
+    unsigned char hdr[6];
+    if (decompress) {
+        if (read_full(in, hdr, sizeof(hdr)) != sizeof(hdr) || read_u16(hdr) != STREAM_MAGIC_TAG) {
+            fprintf(stderr, "not a streaming container\n");
+            goto out_files;
+        }
+        p.block_size = read_u32(hdr + 2u);
+        if (p.block_size == 0 || p.block_size > MAX_BLOCK_SIZE) {
+            fprintf(stderr, "bad stream block size %zu\n", p.block_size);
+            goto out_files;
+        }
+    } else {
+        write_u16(hdr, STREAM_MAGIC_TAG);
+        write_u32(hdr + 2u, (uint32_t)p.block_size);
+        if (fwrite(hdr, 1u, sizeof(hdr), out) != sizeof(hdr)) {
+            fprintf(stderr, "short write\n");
+            goto out_files;
+        }
+    }
+
+    p.slot_count = (size_t)threads * STREAM_SLOTS_PER_THREAD + 2u;
+    p.slots = (stream_slot_t *)calloc(p.slot_count, sizeof(stream_slot_t));
+    if (!p.slots) {
+        fprintf(stderr, "calloc failed\n");
+        goto out_files;
+    }
+    size_t cap = p.block_size + p.block_size / 16u + 64u + 3u;
+    for (size_t i = 0; i < p.slot_count; ++i) {
+        p.slots[i].raw = (unsigned char *)malloc(p.block_size);
+        p.slots[i].frame = (unsigned char *)malloc(STREAM_FRAME_HDR + cap);
+        if (!p.slots[i].raw || !p.slots[i].frame) {
+            fprintf(stderr, "malloc failed\n");
+            goto out_slots;
+        }
+        p.slots[i].comp = p.slots[i].frame + STREAM_FRAME_HDR;
+    }
+
+    /* Everything already written through `out` must be flushed before the
+     * writer switches to positional writes behind the stdio buffer. */
+    if (io_mode != STREAM_IO_SYNC) {
+        lzo_aio_backend_t backend = io_mode == STREAM_IO_URING ? LZO_AIO_URING
+                                  : io_mode == STREAM_IO_THREAD ? LZO_AIO_THREAD : LZO_AIO_AUTO;
+        if (!decompress && is_regular_file(in, &p.in_size))
+            p.rd_aio = lzo_aio_create((unsigned)p.slot_count, backend);
+        if (is_regular_file(out, NULL) && fflush(out) == 0) {
+            p.wr_aio = lzo_aio_create((unsigned)p.slot_count, backend);
+            p.out_pos = decompress ? 0u : sizeof(hdr);
+        }
+        if (io_mode == STREAM_IO_URING && (!p.wr_aio || (!decompress && !p.rd_aio))) {
+            fprintf(stderr, "io_uring is not available for these files\n");
+            goto out_aio;
+        }
+    }
+
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.cond, NULL);
+    lzo_pool_t *pool = get_pool(threads);
+    if (!pool) {
+        fprintf(stderr, "failed to start worker pool\n");
+        goto out_sync;
+    }
+    /* The writer keeps a dedicated thread: it must run alongside every
+     * worker, which a pool task queued behind them cannot guarantee. */
+    pthread_t writer;
+    lzo_pool_submit(pool, (size_t)threads, stream_worker, &p);
+    pthread_create(&writer, NULL, stream_writer, &p);
+
+    for (size_t seq = 0; !p.rd_aio; ++seq) {
+        stream_slot_t *slot = &p.slots[seq % p.slot_count];
+        pthread_mutex_lock(&p.lock);
+        while (p.status == LZO_E_OK && slot->state != SLOT_FREE)
+            pthread_cond_wait(&p.cond, &p.lock);
+        int stop = p.status != LZO_E_OK;
+        pthread_mutex_unlock(&p.lock);
+        if (stop) break;
+
+        int r = stream_read_block(&p, slot);
+        if (r < 0) {
+            stream_fail(&p, LZO_E_ERROR);
+            break;
+        }
+
+        pthread_mutex_lock(&p.lock);
+        if (r > 0) {
+            slot->seq = seq;
+            slot->state = SLOT_FILLED;
+            p.next_read = seq + 1u;
+        } else {
+            p.eof = 1;
+        }
+        pthread_cond_broadcast(&p.cond);
+        pthread_mutex_unlock(&p.lock);
+        if (r == 0) break;
+    }
+    if (p.rd_aio) stream_read_ahead(&p);
+
+    lzo_pool_wait(pool);
+    pthread_join(writer, NULL);
+
+    if (p.status != LZO_E_OK) {
+        fprintf(stderr, "%s failed: %d\n", decompress ? "decompress" : "compress", p.status);
+        goto out_sync;
+    }
+    if (!decompress) {
+        unsigned char term[4];
+        lzo_aio_event_t ev;
+        write_u32(term, 0u);
+        int ok = p.wr_aio
+            ? lzo_aio_write(p.wr_aio, p.out_fd, term, sizeof(term), p.out_pos, NULL) == 0 &&
+              lzo_aio_wait(p.wr_aio, &ev) == 0 && ev.res == (long long)sizeof(term)
+            : fwrite(term, 1u, sizeof(term), out) == sizeof(term);
+        if (!ok) {
+            fprintf(stderr, "short write\n");
+            goto out_sync;
+        }
+    }
+    if (fflush(out) != 0) {
+        perror(output_path);
+        goto out_sync;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    double total_ms = diff_ms_ts(&t_start, &t_end);
+    size_t raw_total = decompress ? p.total_out : p.total_in;
+    if (decompress) {
+        fprintf(stderr,
+                "Decompressed %zu bytes -> %zu bytes (blocks=%zu block_sz=%zu threads=%d stream io=%s time=%.3f ms %.2f MB/s)\n",
+                p.total_in, p.total_out, p.next_read, p.block_size, threads,
+                stream_io_name(&p), total_ms,
+                total_ms > 0.0 ? (raw_total / 1048576.0) / (total_ms / 1000.0) : 0.0);
+    } else {
+        fprintf(stderr,
+                "Compressed %zu bytes -> %zu bytes (%.2f%%) blocks=%zu block_sz=%zu threads=%d alg=%s stream io=%s\n",
+                p.total_in, p.total_out,
+                p.total_in ? (100.0 * p.total_out / p.total_in) : 0.0,
+                p.next_read, p.block_size, threads, alg_to_str(p.compression_alg),
+                stream_io_name(&p));
+        fprintf(stderr, "[TIMING] 总耗时=%.3fms (%.2f MB/s)\n", total_ms,
+                total_ms > 0.0 ? (raw_total / 1048576.0) / (total_ms / 1000.0) : 0.0);
+    }
+    rc = 0;
+
+out_sync:
+    pthread_cond_destroy(&p.cond);
+    pthread_mutex_destroy(&p.lock);
+out_aio:
+    lzo_aio_destroy(p.rd_aio);
+    lzo_aio_destroy(p.wr_aio);
+out_slots:
+    for (size_t i = 0; i < p.slot_count; ++i) {
+        free(p.slots[i].raw);
+        free(p.slots[i].frame);
+    }
+    free(p.slots);
+out_files:
+    if (!from_stdin) fclose(in);
+    if (!to_stdout) fclose(out);
+    return rc;
+}
+
 static int parse_int(const char *s, int *out) {
     if (!s || !out) return -1;
     char *end = NULL;
@@ -925,6 +2323,21 @@ static int parse_int(const char *s, int *out) {
     return 0;
 }
 
+/* Parse "off:len" into two unsigned 64-bit values; len must be non-zero. */
+static int parse_range(const char *s, uint64_t *off, uint64_t *len) {
+    if (!s || !off || !len) return -1;
+    char *end = NULL;
+    errno = 0;
+    unsigned long long a = strtoull(s, &end, 0);
+    if (errno != 0 || end == s || *end != ':' || s[0] == '-') return -1;
+    const char *t = end + 1;
+    unsigned long long b = strtoull(t, &end, 0);
+    if (errno != 0 || end == t || *end != '\0' || t[0] == '-' || b == 0) return -1;
+    *off = (uint64_t)a;
+    *len = (uint64_t)b;
+    return 0;
+}
+
 static void print_usage(const char *prog) {
         fprintf(stderr,
             "Usage: %s [options] <input> [output]\n"
@@ -933,8 +2346,34 @@ static void print_usage(const char *prog) {
             "  -t <threads>    Worker thread count (default %d)\n"
             "  --verify        Verify round-trip instead of writing outputs\n"
             "  -L <alg>        Select algorithm variant.\n"
-            "                  Allowed values: 1, 1k, 1l, 1o. Not valid with -d.\n"
+            "                  Allowed values: 1, 1k, 1l, 1o, or 1:<n> for lzo1x_1\n"
+            "                  with acceleration n (1..65536; higher is faster,\n"
+            "                  compresses less), 999 or 999:<1..10> for lzo1x_999\n"
+            "                  at that level (default 8, 10 parses optimally).\n"
+            "                  Not valid with -d.\n"
             "  --benchmark     Run benchmark metrics after operation\n"
+            "  --format <1|2>  Container format: 1 (32-bit sizes, default) or 2\n"
+            "                  (64-bit sizes; chosen automatically above 4 GiB)\n"
+            "  --index         Store a block offset index (implies --format 2)\n"
+            "  --chain         With -L 999, prime each block with the 48 KiB of\n"
+            "                  input before it; decoding is then sequential\n"
+            "                  (implies --format 2, not valid with --index)\n"
+            "  --checksum <c>  Store crc32 or adler32 sums of every block and of\n"
+            "                  the whole input, checked on -d (implies --format 2)\n"
+            "  --dict <file>   Compress every block against the last 48 KiB of\n"
+            "                  <file> (-L 1 or 999; implies --format 2); -d needs\n"
+            "                  the same file. Helps most with small inputs\n"
+            "  --block-size <n|auto>\n"
+            "                  Block size in bytes (65536..1048576), or auto to\n"
+            "                  size blocks from sampled compression cost\n"
+            "  --range <o:l>   With -d, decompress only bytes [o, o+l) via the index\n"
+            "  --stream        Bounded-memory streaming mode: read, compress and\n"
+            "                  write overlap; use with -d to decode stream output\n"
+            "  --io <m>        Stream file I/O: auto (io_uring, else a pread/pwrite\n"
+            "                  thread; default), uring, thread or sync (stdio)\n"
+            "  --sched <s>     Block scheduler: steal (per-thread ranges with work\n"
+            "                  stealing, default) or atomic (shared counter)\n"
+            "  --sched-bench   Compare both schedulers at 1-128 threads on <input>\n"
             "  -h, --help      Show this help\n"
             "  Use '-' for stdin/stdout. Output defaults to input with .lzo (compress)\n"
             "  or stripped .lzo extension (decompress).\n",
@@ -954,7 +2393,16 @@ int main(int argc, char **argv) {
     int bench_mode = 0; /* concise bench output (compression ratio, throughput) */
     int verbose = 0;
     int verify_only = 0;
+    int stream_mode = 0;
+    int sched_bench = 0;
+    int io_mode = STREAM_IO_AUTO;
+    size_t block_req = 0;
+    int format = 1;
+    unsigned container_flags = 0;
+    int range_mode = 0;
+    uint64_t range_off = 0, range_len = 0;
     char *kernel_spec = NULL;
+    const char *dict_path = NULL;
 
     const char *input = NULL;
     const char *output = NULL;
@@ -986,6 +2434,95 @@ int main(int argc, char **argv) {
             do_bench = 1;
         } else if (strcmp(arg, "--verify") == 0) {
             verify_only = 1;
+        } else if (strcmp(arg, "--stream") == 0) {
+            stream_mode = 1;
+        } else if (strcmp(arg, "--sched") == 0) {
+            const char *v = i + 1 < argc ? argv[++i] : "";
+            if (strcmp(v, "atomic") == 0) {
+                g_sched = LZO_POOL_SCHED_ATOMIC;
+            } else if (strcmp(v, "steal") == 0) {
+                g_sched = LZO_POOL_SCHED_STEAL;
+            } else {
+                fprintf(stderr, "--sched accepts only: atomic, steal\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+        } else if (strcmp(arg, "--io") == 0) {
+            const char *v = i + 1 < argc ? argv[++i] : "";
+            if (strcmp(v, "auto") == 0) {
+                io_mode = STREAM_IO_AUTO;
+            } else if (strcmp(v, "uring") == 0) {
+                io_mode = STREAM_IO_URING;
+            } else if (strcmp(v, "thread") == 0) {
+                io_mode = STREAM_IO_THREAD;
+            } else if (strcmp(v, "sync") == 0) {
+                io_mode = STREAM_IO_SYNC;
+            } else {
+                fprintf(stderr, "--io accepts only: auto, uring, thread, sync\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+        } else if (strcmp(arg, "--block-size") == 0) {
+            int v = 0;
+            if (i + 1 < argc && strcmp(argv[i + 1], "auto") == 0) {
+                block_req = BLOCK_SIZE_AUTO;
+            } else if (i + 1 < argc && parse_int(argv[i + 1], &v) == 0 &&
+                       (size_t)v >= MIN_BLOCK_SIZE && (size_t)v <= MAX_BLOCK_SIZE) {
+                block_req = (size_t)v;
+            } else {
+                fprintf(stderr, "--block-size expects auto or %u..%u bytes\n",
+                        MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+            ++i;
+        } else if (strcmp(arg, "--sched-bench") == 0) {
+            sched_bench = 1;
+        } else if (strcmp(arg, "--index") == 0) {
+            container_flags |= CONTAINER_FLAG_INDEX;
+        } else if (strcmp(arg, "--chain") == 0) {
+            container_flags |= CONTAINER_FLAG_CHAINED;
+        } else if (strcmp(arg, "--dict") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "--dict requires a file\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+            dict_path = argv[++i];
+        } else if (strcmp(arg, "--checksum") == 0) {
+            const char *v = i + 1 < argc ? argv[++i] : "";
+            container_flags &= ~CONTAINER_FLAG_CHECKSUM;
+            if (strcmp(v, "crc32") == 0) {
+                container_flags |= CONTAINER_FLAG_CRC32;
+            } else if (strcmp(v, "adler32") == 0) {
+                container_flags |= CONTAINER_FLAG_ADLER32;
+            } else {
+                fprintf(stderr, "--checksum accepts only: crc32, adler32\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+        } else if (strcmp(arg, "--range") == 0) {
+            if (i + 1 >= argc || parse_range(argv[i + 1], &range_off, &range_len) != 0) {
+                fprintf(stderr, "--range expects <offset>:<length>\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+            range_mode = 1;
+            ++i;
+        } else if (strcmp(arg, "--format") == 0) {
+            if (i + 1 >= argc || parse_int(argv[i + 1], &format) != 0 || format > 2) {
+                fprintf(stderr, "--format accepts only: 1, 2\n");
+                print_usage(argv[0]);
+                free(auto_output);
+                return 1;
+            }
+            ++i;
         } else if (strcmp(arg, "-L") == 0) {
             if (i + 1 >= argc) {
                 fprintf(stderr, "-L requires an argument\n");
@@ -1001,9 +2538,9 @@ int main(int argc, char **argv) {
             }
             kernel_spec = argv[++i];
             /* validate allowed labels */
-            if (!(strcasecmp(kernel_spec, "1") == 0 || strcasecmp(kernel_spec, "1k") == 0 ||
-                  strcasecmp(kernel_spec, "1l") == 0 || strcasecmp(kernel_spec, "1o") == 0)) {
-                fprintf(stderr, "-L accepts only: 1, 1k, 1l, 1o\n");
+            if (alg_from_spec(kernel_spec) == ALG_NONE) {
+                fprintf(stderr, "-L accepts only: 1, 1k, 1l, 1o, 1:<n> (n = 1..%d), 999, 999:<1..10>\n",
+                        ACCEL_MAX);
                 print_usage(argv[0]);
                 free(auto_output);
                 return 1;
@@ -1011,6 +2548,10 @@ int main(int argc, char **argv) {
             /* set global algorithm label immediately */
             g_alg_spec = kernel_spec;
             g_alg = alg_from_spec(g_alg_spec);
+            if (g_alg == ALG_1X)
+                g_accel = accel_from_spec(g_alg_spec);
+            else if (g_alg == ALG_999)
+                g_level_999 = level_999_from_spec(g_alg_spec);
         } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
             print_usage(argv[0]);
             free(auto_output);
@@ -1040,6 +2581,42 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (range_mode && (!mode_decompress || stream_mode || verify_only)) {
+        fprintf(stderr, "--range requires -d and cannot be combined with --stream or --verify\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (stream_mode && (verify_only || do_bench || bench_mode)) {
+        fprintf(stderr, "--stream cannot be combined with --verify or benchmark modes\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if ((container_flags & CONTAINER_FLAG_CHAINED) &&
+        (g_alg != ALG_999 || mode_decompress || stream_mode || (container_flags & CONTAINER_FLAG_INDEX))) {
+        fprintf(stderr, "--chain requires -L 999 and cannot be combined with -d, --stream or --index\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    /* lzo1x_1 takes a dictionary only without an acceleration factor */
+    if (dict_path &&
+        ((g_alg != ALG_NONE && g_alg != ALG_1X && g_alg != ALG_999) || g_accel != 1 ||
+         stream_mode || (container_flags & CONTAINER_FLAG_CHAINED))) {
+        fprintf(stderr, "--dict requires -L 1 or 999 and cannot be combined with --stream or --chain\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (dict_path) {
+        if (load_dict(dict_path) != 0) {
+            free(g_dict_buf);
+            free(g_dict_prep);
+            return 1;
+        }
+        if (!mode_decompress) container_flags |= CONTAINER_FLAG_DICT;
+    }
+
     if (!output) {
         if (strcmp(input, "-") == 0) {
             output = "-";
@@ -1095,10 +2672,24 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (mode_decompress) {
+    if (sched_bench) {
+        file_map_t in_map;
+        if (map_input(input, &in_map) != 0) {
+            rc = 1;
+        } else {
+            run_sched_benchmark(in_map.data, in_map.size, level);
+            release_map(&in_map);
+            rc = 0;
+        }
+    } else if (stream_mode) {
+        rc = stream_file(input, output, level, threads, mode_decompress, io_mode);
+    } else if (range_mode) {
+        rc = decompress_range(input, output, range_off, range_len);
+    } else if (mode_decompress) {
         rc = decompress_file(input, output, threads, verify_only);
     } else {
-        rc = compress_file(input, output, level, threads, do_bench, verify_only);
+        rc = compress_file(input, output, level, threads, do_bench, verify_only,
+                           format, container_flags, block_req);
         /* concise bench mode: if requested and not already covered by --benchmark,
          * run a single-block measure and print a compact benchmark summary.
          */
@@ -1122,7 +2713,7 @@ int main(int argc, char **argv) {
                     unsigned char *out = malloc(input_size ? input_size : 1u);
                     struct timespec dt0, dt1;
                     clock_gettime(clk, &dt0);
-                    r = decompress_block(comp, comp_len, out, input_size);
+                    r = decompress_block(comp, comp_len, out, input_size, 0);
                     clock_gettime(clk, &dt1);
                     double decomp_ms = diff_ms_ts(&dt0, &dt1);
                     double comp_mb_s = input_size ? (input_size / 1048576.0) / (comp_ms / 1000.0) : 0.0;
@@ -1138,30 +2729,37 @@ int main(int argc, char **argv) {
         }
     }
 
+    lzo_pool_destroy(g_pool);
+    free(g_dict_prep);
+    free(g_dict_buf);
     free(auto_output);
     return rc;
 }
 
 /* Compress into a caller-provided buffer `out` with capacity `out_cap`.
  * Returns LZO_E_OK on success and sets *out_size to the compressed length.
+ * ALG_999 primes the match finder with the `hist` bytes before `in`; the
+ * other compressors ignore it. Without hist, ALG_1X and ALG_999 use the
+ * --dict dictionary when there is one.
  */
-static int compress_block_into(const unsigned char *in, size_t in_size,
+static int compress_block_into(const unsigned char *in, size_t in_size, size_t hist,
                                unsigned char *out, size_t out_cap, size_t *out_size,
                                alg_t compression_alg, void *wrkmem_in) {
     if (!out || out_cap == 0) return LZO_E_OUT_OF_MEMORY;
-    lzo_align_t *wrkmem_ptr = NULL;
-    if (wrkmem_in) {
-        wrkmem_ptr = (lzo_align_t *)wrkmem_in;
-    } else {
-        HEAP_ALLOC(_wrkmem_local, LZO_WORK_MEM_SIZE);
-        wrkmem_ptr = _wrkmem_local;
-    }
+    void *wrkmem_local = NULL;
+    if (!wrkmem_in && posix_memalign(&wrkmem_local, sizeof(lzo_align_t), LZO_WORK_MEM_SIZE) != 0)
+        return LZO_E_OUT_OF_MEMORY;
+    lzo_align_t *wrkmem_ptr = (lzo_align_t *)(wrkmem_in ? wrkmem_in : wrkmem_local);
 
     lzo_uint dst_len = (lzo_uint)out_cap;
     int rc;
     switch (compression_alg) {
         case ALG_1X:
-            rc = lzo1x_1_compress(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr);
+            if (g_dict)
+                rc = lzo1x_1_compress_dict_prepared(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr,
+                                                    g_dict, (lzo_uint)g_dict_len, g_dict_prep);
+            else
+                rc = lzo1x_1_compress_accel(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr, g_accel);
             break;
         case ALG_1K:
             rc = lzo1x_1_12_compress(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr);
@@ -1172,10 +2770,17 @@ static int compress_block_into(const unsigned char *in, size_t in_size,
         case ALG_1L:
             rc = lzo1x_1_11_compress(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr);
             break;
+        case ALG_999:
+            rc = lzo1x_999_compress_level(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr,
+                                          hist ? in - hist : g_dict,
+                                          (lzo_uint)(hist ? hist : g_dict_len), NULL,
+                                          g_level_999);
+            break;
         default:
             rc = lzo1x_1_compress(in, (lzo_uint)in_size, out, &dst_len, wrkmem_ptr);
             break;
     }
+    free(wrkmem_local);
     if (rc != LZO_E_OK) return rc;
     *out_size = (size_t)dst_len;
     return LZO_E_OK;
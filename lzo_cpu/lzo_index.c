@@ -0,0 +1,262 @@
+/*
+ * lzo_index.c -- random-access block index for lzo_cpu containers
+ * Resolves a byte range of the original data to the blocks that cover it
+ * and decompresses only those, reading just the header, the relevant part
+ * of the offset table and the covering payload from the file.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <lzo/lzo1x.h>
+#include "lzo_index.h"
+
+static uint32_t rd_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t rd_u64(const unsigned char *p) {
+    return (uint64_t)rd_u32(p) | ((uint64_t)rd_u32(p + 4) << 32);
+}
+
+static int seek_to(FILE *fp, uint64_t pos) {
+#ifdef _WIN32
+    return _fseeki64(fp, (__int64)pos, SEEK_SET);
+#else
+    return fseeko(fp, (off_t)pos, SEEK_SET);
+#endif
+}
+
+static int read_at(FILE *fp, uint64_t pos, unsigned char *buf, size_t len) {
+    if (seek_to(fp, pos) != 0) return -1;
+    return fread(buf, 1u, len, fp) == len ? 0 : -1;
+}
+
+int lzo_index_open(FILE *fp, lzo_index_t *idx) {
+    unsigned char hdr[HEADER_SIZE_V2];
+    memset(idx, 0, sizeof(*idx));
+
+    if (seek_to(fp, 0) != 0) {
+        fprintf(stderr, "input is not seekable\n");
+        return -1;
+    }
+    size_t got = fread(hdr, 1u, sizeof(hdr), fp);
+    if (got < 2u) {
+        fprintf(stderr, "input too small\n");
+        return -1;
+    }
+
+    uint16_t magic = (uint16_t)(hdr[0] | (hdr[1] << 8));
+    uint64_t nblk;
+    if (magic == MAGIC_TAG && got >= HEADER_SIZE_V1) {
+        idx->format = 1;
+        idx->orig_size = rd_u32(hdr + 2u);
+        idx->blk_size = rd_u32(hdr + 6u);
+        nblk = rd_u32(hdr + 10u);
+        idx->table_pos = HEADER_SIZE_V1;
+    } else if (magic == MAGIC_TAG_V2 && got >= HEADER_SIZE_V2) {
+        if (hdr[2] != CONTAINER_VERSION) {
+            fprintf(stderr, "unsupported container version %u\n", (unsigned)hdr[2]);
+            return -1;
+        }
+        idx->format = 2;
+        idx->flags = hdr[3];
+        if (idx->flags & CONTAINER_FLAG_CHAINED) {
+            fprintf(stderr, "chained containers have no random access\n");
+            return -1;
+        }
+        idx->orig_size = rd_u64(hdr + 4u);
+        idx->blk_size = rd_u32(hdr + 12u);
+        nblk = rd_u64(hdr + 16u);
+        idx->table_pos = HEADER_SIZE_V2;
+    } else if (magic == STREAM_MAGIC_TAG) {
+        fprintf(stderr, "stream containers have no block index\n");
+        return -1;
+    } else {
+        fprintf(stderr, "bad magic 0x%04x\n", magic);
+        return -1;
+    }
+
+    /* every block but the last holds blk_size bytes and the last one the
+     * rest, so the block count follows from the two sizes */
+    uint64_t want = idx->blk_size
+        ? idx->orig_size / idx->blk_size + (idx->orig_size % idx->blk_size != 0)
+        : (idx->orig_size != 0 ? UINT64_MAX : 0);
+    if (nblk > SIZE_MAX / 8u - 1u || nblk != want) {
+        fprintf(stderr, "inconsistent container header\n");
+        return -1;
+    }
+    idx->nblk = (size_t)nblk;
+
+    uint64_t pos = idx->table_pos + (uint64_t)idx->nblk * 4u;
+    if (idx->flags & CONTAINER_FLAG_INDEX) {
+        idx->index_pos = pos;
+        pos += ((uint64_t)idx->nblk + 1u) * 8u;
+    }
+    if (idx->flags & CONTAINER_FLAG_CHECKSUM) {
+        idx->sum_pos = pos;
+        pos += ((uint64_t)idx->nblk + 1u) * 4u;
+    }
+    if (idx->flags & CONTAINER_FLAG_DICT) {
+        unsigned char raw[4];
+        if (read_at(fp, pos, raw, sizeof(raw)) != 0) {
+            fprintf(stderr, "truncated dictionary checksum\n");
+            return -1;
+        }
+        idx->dict_sum = rd_u32(raw);
+        pos += 4u;
+    }
+    idx->payload_pos = pos;
+    return 0;
+}
+
+void lzo_index_close(lzo_index_t *idx) {
+    free(idx->offsets);
+    idx->offsets = NULL;
+}
+
+int lzo_index_block_range(const lzo_index_t *idx, uint64_t off, uint64_t len,
+                          size_t *first, size_t *last) {
+    if (len == 0 || idx->blk_size == 0 || off >= idx->orig_size || len > idx->orig_size - off)
+        return -1;
+    *first = (size_t)(off / idx->blk_size);
+    *last = (size_t)((off + len - 1u) / idx->blk_size);
+    if (*last >= idx->nblk) *last = idx->nblk - 1u;
+    return *first <= *last ? 0 : -1;
+}
+
+int lzo_index_span(FILE *fp, lzo_index_t *idx, size_t first, size_t last, uint64_t *offs) {
+    size_t n = last - first + 2u;
+
+    if (idx->index_pos) {
+        unsigned char *raw = (unsigned char *)malloc(n * 8u);
+        if (!raw) return -1;
+        int rc = read_at(fp, idx->index_pos + (uint64_t)first * 8u, raw, n * 8u);
+        for (size_t i = 0; rc == 0 && i < n; ++i)
+            offs[i] = rd_u64(raw + i * 8u);
+        free(raw);
+        return rc;
+    }
+
+    if (!idx->offsets) {
+        unsigned char *table = (unsigned char *)malloc(idx->nblk ? idx->nblk * 4u : 1u);
+        uint64_t *sums = (uint64_t *)malloc((idx->nblk + 1u) * sizeof(uint64_t));
+        if (!table || !sums || read_at(fp, idx->table_pos, table, idx->nblk * 4u) != 0) {
+            free(table);
+            free(sums);
+            return -1;
+        }
+        sums[0] = 0;
+        uint32_t mask = (idx->flags & CONTAINER_FLAG_STORED) ? ~BLOCK_STORED_BIT : ~0u;
+        for (size_t i = 0; i < idx->nblk; ++i)
+            sums[i + 1u] = sums[i] + (rd_u32(table + i * 4u) & mask);
+        free(table);
+        idx->offsets = sums;
+    }
+    memcpy(offs, idx->offsets + first, n * sizeof(uint64_t));
+    return 0;
+}
+
+int lzo_index_read_range(FILE *fp, lzo_index_t *idx, uint64_t off, uint64_t len,
+                         unsigned char *dst) {
+    size_t first, last;
+    if (lzo_index_block_range(idx, off, len, &first, &last) != 0)
+        return LZO_E_ERROR;
+    if ((idx->flags & CONTAINER_FLAG_DICT) && !idx->dict)
+        return LZO_E_ERROR;
+
+    size_t n = last - first + 1u;
+    uint64_t *offs = (uint64_t *)malloc((n + 1u) * sizeof(uint64_t));
+    if (!offs) return LZO_E_OUT_OF_MEMORY;
+    if (lzo_index_span(fp, idx, first, last, offs) != 0 || offs[n] - offs[0] > SIZE_MAX) {
+        free(offs);
+        return LZO_E_ERROR;
+    }
+    /* a stored index is read as is: every block must lie inside the span */
+    for (size_t k = 0; k < n; ++k) {
+        if (offs[k] > offs[k + 1u]) {
+            free(offs);
+            return LZO_E_ERROR;
+        }
+    }
+
+    size_t comp_bytes = (size_t)(offs[n] - offs[0]);
+    unsigned char *comp = (unsigned char *)malloc(comp_bytes ? comp_bytes : 1u);
+    unsigned char *tmp = (unsigned char *)malloc(idx->blk_size);
+    /* the stored bits live in the length table, not in the offsets */
+    unsigned char *lens = (idx->flags & CONTAINER_FLAG_STORED) ? (unsigned char *)malloc(n * 4u) : NULL;
+    unsigned char *sums = idx->sum_pos ? (unsigned char *)malloc(n * 4u) : NULL;
+    int rc = LZO_E_OK;
+    if (!comp || !tmp || ((idx->flags & CONTAINER_FLAG_STORED) && !lens) || (idx->sum_pos && !sums)) {
+        rc = LZO_E_OUT_OF_MEMORY;
+    } else if (read_at(fp, idx->payload_pos + offs[0], comp, comp_bytes) != 0 ||
+               (lens && read_at(fp, idx->table_pos + (uint64_t)first * 4u, lens, n * 4u) != 0) ||
+               (sums && read_at(fp, idx->sum_pos + (uint64_t)first * 4u, sums, n * 4u) != 0)) {
+        rc = LZO_E_INPUT_OVERRUN;
+    }
+
+    uint64_t end = off + len;
+    for (size_t k = 0; rc == LZO_E_OK && k < n; ++k) {
+        size_t i = first + k;
+        uint64_t blk_start = (uint64_t)i * idx->blk_size;
+        size_t blk_len = (i == idx->nblk - 1u) ? (size_t)(idx->orig_size - blk_start) : idx->blk_size;
+        uint64_t lo = off > blk_start ? off : blk_start;
+        uint64_t hi = end < blk_start + blk_len ? end : blk_start + blk_len;
+        const unsigned char *src = comp + (size_t)(offs[k] - offs[0]);
+        lzo_uint src_len = (lzo_uint)(offs[k + 1u] - offs[k]);
+
+        /* blocks fully inside the range decompress straight into dst */
+        int whole = (lo == blk_start && hi == blk_start + blk_len);
+        unsigned char *out = whole ? dst + (size_t)(blk_start - off) : tmp;
+        if (!whole && blk_len > idx->blk_size) {
+            rc = LZO_E_ERROR;
+            break;
+        }
+        lzo_uint out_len = (lzo_uint)blk_len;
+        if (lens && (rd_u32(lens + k * 4u) & BLOCK_STORED_BIT)) {
+            if (src_len != (lzo_uint)blk_len) {
+                rc = LZO_E_ERROR;
+                break;
+            }
+            memcpy(out, src, blk_len);
+        } else if (idx->dict) {
+            rc = lzo1x_decompress_dict_safe(src, src_len, out, &out_len, NULL,
+                                            idx->dict, (lzo_uint)idx->dict_len);
+        } else {
+            rc = lzo1x_decompress_safe(src, src_len, out, &out_len, NULL);
+        }
+        if (rc == LZO_E_OK && out_len != (lzo_uint)blk_len) rc = LZO_E_ERROR;
+        if (rc == LZO_E_OK && sums &&
+            lzo_index_checksum(idx->flags, out, blk_len) != rd_u32(sums + k * 4u)) {
+            fprintf(stderr, "checksum mismatch in block %zu\n", i);
+            rc = LZO_E_ERROR;
+        }
+        if (rc == LZO_E_OK && !whole)
+            memcpy(dst + (size_t)(lo - off), tmp + (size_t)(lo - blk_start), (size_t)(hi - lo));
+    }
+
+    free(sums);
+    free(lens);
+    free(tmp);
+    free(comp);
+    free(offs);
+    return rc;
+}
+
+uint32_t lzo_index_checksum(unsigned flags, const unsigned char *buf, size_t len) {
+    if (flags & CONTAINER_FLAG_ADLER32)
+        return lzo_adler32(1u, buf, (lzo_uint)len);
+    return lzo_crc32(0u, buf, (lzo_uint)len);
+}
+
+uint32_t lzo_index_checksum_combine(unsigned flags, uint32_t sum1, uint32_t sum2, size_t len2) {
+    if (flags & CONTAINER_FLAG_ADLER32)
+        return lzo_adler32_combine(sum1, sum2, (lzo_uint)len2);
+    return lzo_crc32_combine(sum1, sum2, (lzo_uint)len2);
+}
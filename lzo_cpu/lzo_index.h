@@ -0,0 +1,101 @@
+/* lzo_index.h - container layout and random-access block index for lzo_cpu
+ *
+ * Indexed containers carry a u32 compressed length per block, so the file
+ * offset of any block is a prefix sum over that table. The functions below
+ * locate and decompress only the blocks that cover a requested byte range
+ * of the original data, reading nothing else from the file.
+ */
+#ifndef LZO_INDEX_H
+#define LZO_INDEX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MAGIC_TAG            0x4C5A       /* 'L''Z' */
+#define MAGIC_TAG_V2         0x4C5B       /* versioned container, 64-bit sizes */
+#define STREAM_MAGIC_TAG     0x4C53       /* 'L''S' */
+#define CONTAINER_VERSION    2
+#define HEADER_SIZE_V1       (2u + 4u + 4u + 4u)
+#define HEADER_SIZE_V2       (2u + 1u + 1u + 8u + 4u + 8u)
+
+/* v2 header flags */
+#define CONTAINER_FLAG_INDEX 0x01u        /* u64 offsets[nblk + 1] follow the length table */
+#define CONTAINER_FLAG_STORED 0x02u       /* length entries may carry BLOCK_STORED_BIT */
+#define CONTAINER_FLAG_CRC32 0x04u        /* u32 sums[nblk + 1] follow: each block, then all */
+#define CONTAINER_FLAG_ADLER32 0x08u      /* the same table holding adler32 values */
+#define CONTAINER_FLAG_CHECKSUM (CONTAINER_FLAG_CRC32 | CONTAINER_FLAG_ADLER32)
+#define CONTAINER_FLAG_CHAINED 0x10u      /* blocks may match into the CHAIN_WINDOW bytes before them */
+#define CONTAINER_FLAG_DICT  0x20u        /* blocks match into a preset dictionary; its u32 adler32 comes last */
+
+/* How far back a chained block may reach: the LZO1X match offset limit.
+ * Decoding such a block needs those bytes of the previous blocks' output,
+ * so chained containers decode in order and have no random access.
+ */
+#define CHAIN_WINDOW         0xBFFFu
+
+/* Set on a v2 length-table entry (with CONTAINER_FLAG_STORED) or a stream
+ * frame's comp_len: the block's payload is its original bytes, uncompressed.
+ */
+#define BLOCK_STORED_BIT     0x80000000u
+
+typedef struct {
+    int format;             /* 1 or 2 */
+    unsigned flags;
+    uint64_t orig_size;
+    size_t blk_size;
+    size_t nblk;
+    uint64_t table_pos;     /* file position of the u32 length table */
+    uint64_t index_pos;     /* file position of the stored offsets, 0 if absent */
+    uint64_t sum_pos;       /* file position of the checksum table, 0 if absent */
+    uint64_t payload_pos;   /* file position of the first block */
+    uint64_t *offsets;      /* nblk + 1 payload-relative prefix sums, computed on demand */
+    uint32_t dict_sum;      /* adler32 of the preset dictionary (CONTAINER_FLAG_DICT) */
+    const unsigned char *dict;  /* that dictionary, set by the caller once checked */
+    size_t dict_len;
+} lzo_index_t;
+
+/* Read the container header from the start of a seekable file.
+ * Returns 0 on success and -1 (with a message on stderr) otherwise.
+ */
+int lzo_index_open(FILE *fp, lzo_index_t *idx);
+void lzo_index_close(lzo_index_t *idx);
+
+/* Map the byte range [off, off + len) of the original data to the block
+ * range [*first, *last]. Returns -1 when the range is empty or out of bounds.
+ */
+int lzo_index_block_range(const lzo_index_t *idx, uint64_t off, uint64_t len,
+                          size_t *first, size_t *last);
+
+/* Fill offs[0 .. last - first + 1] with payload-relative offsets of blocks
+ * first .. last + 1. A stored index is read directly; otherwise the prefix
+ * sums are computed once from the length table and cached in idx.
+ */
+int lzo_index_span(FILE *fp, lzo_index_t *idx, size_t first, size_t last, uint64_t *offs);
+
+/* Decompress original bytes [off, off + len) into dst, touching only the
+ * blocks that overlap the range. Every decoded block is checked against the
+ * checksum table when the container has one. A CONTAINER_FLAG_DICT
+ * container needs idx->dict. Returns an LZO_E_* code.
+ */
+int lzo_index_read_range(FILE *fp, lzo_index_t *idx, uint64_t off, uint64_t len,
+                         unsigned char *dst);
+
+/* Checksum of the original data in the algorithm named by the
+ * CONTAINER_FLAG_CHECKSUM bits of `flags`; (flags, NULL, 0) is the value
+ * for empty input. The combine form returns the checksum of two adjacent
+ * buffers from theirs and the second one's length, so per-block sums
+ * merge into the whole-input sum without another pass over the data.
+ */
+uint32_t lzo_index_checksum(unsigned flags, const unsigned char *buf, size_t len);
+uint32_t lzo_index_checksum_combine(unsigned flags, uint32_t sum1, uint32_t sum2, size_t len2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZO_INDEX_H */
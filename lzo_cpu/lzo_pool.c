@@ -0,0 +1,277 @@
+/*
+ * lzo_pool.c -- persistent worker pool for lzo_cpu
+ * Threads sleep on a condition variable between jobs and are woken by a
+ * generation counter. Within a job they either pull task indices from one
+ * atomic counter or work through per-thread ranges, stealing from their
+ * peers once their own range runs dry.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lzo/lzoconf.h>
+#include "lzo_pool.h"
+
+#define POOL_CACHE_LINE 64u
+
+/* A thread's share of the index space, head in the low and tail in the high
+ * 32 bits so that both ends move with a single CAS. Padded to a cache line
+ * so owners popping from neighbouring ranges do not contend.
+ */
+typedef struct {
+    _Atomic uint64_t range;
+    char pad[POOL_CACHE_LINE - sizeof(uint64_t)];
+} pool_range_t;
+
+struct lzo_pool {
+    pthread_t *tids;
+    void **wrkmem;
+    int threads;
+    int started;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;   /* signalled when a job is queued or on shutdown */
+    pthread_cond_t done_cond;   /* signalled when the last thread leaves a job */
+    unsigned long generation;
+    int active;                 /* threads still inside the current job */
+    int shutdown;
+
+    lzo_pool_sched_t sched;
+    pool_range_t *ranges;       /* one per thread, LZO_POOL_SCHED_STEAL only */
+
+    lzo_pool_task_fn fn;
+    void *arg;
+    size_t count;
+    int steal;                  /* current job uses the per-thread ranges */
+    _Atomic size_t next_index;
+    _Atomic int status;
+};
+
+typedef struct {
+    lzo_pool_t *pool;
+    int id;
+} pool_thread_arg_t;
+
+static uint64_t range_pack(uint32_t head, uint32_t tail) {
+    return (uint64_t)head | ((uint64_t)tail << 32);
+}
+
+/* Owner side: take the index at the front of the range. */
+static int range_pop(pool_range_t *r, size_t *idx) {
+    uint64_t w = atomic_load(&r->range);
+    for (;;) {
+        uint32_t head = (uint32_t)w, tail = (uint32_t)(w >> 32);
+        if (head >= tail) return 0;
+        if (atomic_compare_exchange_weak(&r->range, &w, range_pack(head + 1u, tail))) {
+            *idx = head;
+            return 1;
+        }
+    }
+}
+
+/* Thief side: detach the back half of a victim's range as [*lo, *hi). */
+static int range_steal(pool_range_t *r, uint32_t *lo, uint32_t *hi) {
+    uint64_t w = atomic_load(&r->range);
+    for (;;) {
+        uint32_t head = (uint32_t)w, tail = (uint32_t)(w >> 32);
+        if (head >= tail) return 0;
+        uint32_t split = tail - (tail - head + 1u) / 2u;
+        if (atomic_compare_exchange_weak(&r->range, &w, range_pack(head, split))) {
+            *lo = split;
+            *hi = tail;
+            return 1;
+        }
+    }
+}
+
+/* Next index for thread `id`: its own range first, then the victims in
+ * round-robin order starting at its neighbour. Work is never added during
+ * a job, so one fruitless pass over every range means the job is drained.
+ */
+static int steal_next(lzo_pool_t *pool, int id, size_t *idx) {
+    pool_range_t *own = &pool->ranges[id];
+    if (range_pop(own, idx)) return 1;
+    for (int k = 1; k < pool->started; ++k) {
+        uint32_t lo, hi;
+        if (range_steal(&pool->ranges[(id + k) % pool->started], &lo, &hi)) {
+            /* own range is empty, so no thief can be racing on it */
+            atomic_store(&own->range, range_pack(lo + 1u, hi));
+            *idx = lo;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *pool_thread(void *opaque) {
+    pool_thread_arg_t *ta = (pool_thread_arg_t *)opaque;
+    lzo_pool_t *pool = ta->pool;
+    int id = ta->id;
+    void *wrkmem = pool->wrkmem[id];
+    unsigned long seen = 0;
+    free(ta);
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen)
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        lzo_pool_task_fn fn = pool->fn;
+        void *arg = pool->arg;
+        size_t count = pool->count;
+        int steal = pool->steal;
+        pthread_mutex_unlock(&pool->lock);
+
+        for (;;) {
+            size_t idx;
+            if (steal) {
+                if (!steal_next(pool, id, &idx)) break;
+            } else {
+                idx = atomic_fetch_add(&pool->next_index, (size_t)1);
+                if (idx >= count) break;
+            }
+            if (atomic_load(&pool->status) != LZO_E_OK) break;
+            int rc = fn(arg, idx, wrkmem);
+            if (rc != LZO_E_OK) {
+                int expected = LZO_E_OK;
+                atomic_compare_exchange_strong(&pool->status, &expected, rc);
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+            pthread_cond_broadcast(&pool->done_cond);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+lzo_pool_t *lzo_pool_create(int threads, size_t wrkmem_size) {
+    if (threads < 1) threads = 1;
+    lzo_pool_t *pool = (lzo_pool_t *)calloc(1u, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->threads = threads;
+    pool->sched = LZO_POOL_SCHED_STEAL;
+    pool->tids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    pool->wrkmem = (void **)calloc((size_t)threads, sizeof(void *));
+    if (posix_memalign((void **)&pool->ranges, POOL_CACHE_LINE,
+                       (size_t)threads * sizeof(pool_range_t)) != 0)
+        pool->ranges = NULL;
+    if (!pool->tids || !pool->wrkmem || !pool->ranges) {
+        free(pool->ranges);
+        free(pool->tids);
+        free(pool->wrkmem);
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < threads; ++i)
+        atomic_init(&pool->ranges[i].range, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    atomic_store(&pool->next_index, (size_t)0);
+    atomic_store(&pool->status, LZO_E_OK);
+
+    for (int i = 0; i < threads; ++i) {
+        if (wrkmem_size &&
+            posix_memalign(&pool->wrkmem[i], sizeof(lzo_align_t), wrkmem_size) != 0) {
+            pool->wrkmem[i] = NULL;
+            lzo_pool_destroy(pool);
+            return NULL;
+        }
+        pool_thread_arg_t *ta = (pool_thread_arg_t *)malloc(sizeof(*ta));
+        if (!ta) {
+            lzo_pool_destroy(pool);
+            return NULL;
+        }
+        ta->pool = pool;
+        ta->id = i;
+        if (pthread_create(&pool->tids[i], NULL, pool_thread, ta) != 0) {
+            free(ta);
+            lzo_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+    return pool;
+}
+
+void lzo_pool_destroy(lzo_pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->started; ++i)
+        pthread_join(pool->tids[i], NULL);
+    for (int i = 0; i < pool->threads; ++i)
+        free(pool->wrkmem[i]);
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->ranges);
+    free(pool->wrkmem);
+    free(pool->tids);
+    free(pool);
+}
+
+int lzo_pool_threads(const lzo_pool_t *pool) {
+    return pool ? pool->threads : 0;
+}
+
+void lzo_pool_set_sched(lzo_pool_t *pool, lzo_pool_sched_t sched) {
+    pthread_mutex_lock(&pool->lock);
+    pool->sched = sched;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void lzo_pool_submit(lzo_pool_t *pool, size_t count, lzo_pool_task_fn fn, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->count = count;
+    atomic_store(&pool->next_index, (size_t)0);
+    atomic_store(&pool->status, LZO_E_OK);
+    /* ranges are 32-bit; larger jobs fall back to the shared counter */
+    pool->steal = pool->sched == LZO_POOL_SCHED_STEAL && count <= UINT32_MAX;
+    if (pool->steal) {
+        size_t n = (size_t)pool->started;
+        for (size_t i = 0; i < n; ++i)
+            atomic_store(&pool->ranges[i].range,
+                         range_pack((uint32_t)(count * i / n), (uint32_t)(count * (i + 1u) / n)));
+    }
+    pool->active = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int lzo_pool_wait(lzo_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    int rc = atomic_load(&pool->status);
+    pthread_mutex_unlock(&pool->lock);
+    return rc;
+}
+
+int lzo_pool_run(lzo_pool_t *pool, size_t count, lzo_pool_task_fn fn, void *arg) {
+    if (count == 0) return LZO_E_OK;
+    lzo_pool_submit(pool, count, fn, arg);
+    return lzo_pool_wait(pool);
+}
@@ -0,0 +1,59 @@
+/* lzo_pool.h - persistent worker pool for lzo_cpu
+ *
+ * A pool owns a fixed set of threads and one aligned work memory area per
+ * thread, both kept alive between jobs. A job is a task function applied
+ * to the indices [0, count), so submitting a job costs a wakeup rather
+ * than thread creation and a fresh LZO1X_1_MEM_COMPRESS allocation.
+ *
+ * Threads either claim indices one at a time from a shared counter
+ * (LZO_POOL_SCHED_ATOMIC) or each start on a contiguous range of them and
+ * steal from the other threads' ranges once their own runs out
+ * (LZO_POOL_SCHED_STEAL, the default).
+ */
+#ifndef LZO_POOL_H
+#define LZO_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lzo_pool lzo_pool_t;
+
+typedef enum {
+    LZO_POOL_SCHED_ATOMIC = 0,  /* shared fetch-and-add counter */
+    LZO_POOL_SCHED_STEAL,       /* per-thread ranges with work stealing */
+} lzo_pool_sched_t;
+
+/* Process task `index` of the current job using the calling thread's work
+ * memory. Return LZO_E_OK, or an error code to cancel the remaining tasks.
+ */
+typedef int (*lzo_pool_task_fn)(void *arg, size_t index, void *wrkmem);
+
+/* Start `threads` workers, each with `wrkmem_size` bytes of work memory
+ * (0 for none). Returns NULL when threads or memory cannot be obtained.
+ */
+lzo_pool_t *lzo_pool_create(int threads, size_t wrkmem_size);
+void lzo_pool_destroy(lzo_pool_t *pool);
+int lzo_pool_threads(const lzo_pool_t *pool);
+
+/* Select how the next jobs are scheduled (default LZO_POOL_SCHED_STEAL). */
+void lzo_pool_set_sched(lzo_pool_t *pool, lzo_pool_sched_t sched);
+
+/* Queue a job and return immediately. Only one job runs at a time; a
+ * second submit waits for the previous job to finish.
+ */
+void lzo_pool_submit(lzo_pool_t *pool, size_t count, lzo_pool_task_fn fn, void *arg);
+
+/* Wait for the submitted job and return LZO_E_OK or its first error. */
+int lzo_pool_wait(lzo_pool_t *pool);
+
+/* lzo_pool_submit() followed by lzo_pool_wait(). */
+int lzo_pool_run(lzo_pool_t *pool, size_t count, lzo_pool_task_fn fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LZO_POOL_H */
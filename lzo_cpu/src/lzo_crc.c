@@ -111,21 +111,14 @@ lzo_get_crc32_table(void)
 #define LZO_DO16(buf,i) LZO_DO8(buf,i); LZO_DO8(buf,i+8)
 
 
-LZO_PUBLIC(lzo_uint32_t)
-lzo_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len)
+/* all kernels work on the inverted crc and return it inverted */
+typedef lzo_uint32_t (*lzo_crc32_kernel_t)(lzo_uint32_t, const lzo_bytep, lzo_uint);
+
+static lzo_uint32_t
+lzo_crc32_bytewise(lzo_uint32_t crc, const lzo_bytep buf, lzo_uint len)
 {
-    lzo_uint32_t crc;
 #undef table
-#if 1
-#  define table lzo_crc32_table
-#else
-   const lzo_uint32_t * table = lzo_crc32_table;
-#endif
-
-    if (buf == NULL)
-        return 0;
-
-    crc = (c & LZO_UINT32_C(0xffffffff)) ^ LZO_UINT32_C(0xffffffff);
+#define table lzo_crc32_table
     if (len >= 16) do
     {
         LZO_DO16(buf,0);
@@ -138,9 +131,244 @@ lzo_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len)
         buf += 1;
         len -= 1;
     } while (len > 0);
+    return crc;
+#undef table
+}
+
+
+/***********************************************************************
+// slicing-by-8: eight bytes per step through eight derived tables,
+// lzo_crc32_slice[k-1][n] being the crc of byte n followed by k zeros
+************************************************************************/
+
+static lzo_uint32_t lzo_crc32_slice[7][256];
+
+#define LZO_GET_LE32(p) \
+    ((lzo_uint32_t)(p)[0] | ((lzo_uint32_t)(p)[1] << 8) | \
+     ((lzo_uint32_t)(p)[2] << 16) | ((lzo_uint32_t)(p)[3] << 24))
+
+static lzo_uint32_t
+lzo_crc32_slice8(lzo_uint32_t crc, const lzo_bytep buf, lzo_uint len)
+{
+    const lzo_uint32_t *t0 = lzo_crc32_table;
+    while (len >= 8)
+    {
+        lzo_uint32_t lo = crc ^ LZO_GET_LE32(buf);
+        lzo_uint32_t hi = LZO_GET_LE32(buf + 4);
+        crc = lzo_crc32_slice[6][lo & 0xff] ^ lzo_crc32_slice[5][(lo >> 8) & 0xff] ^
+              lzo_crc32_slice[4][(lo >> 16) & 0xff] ^ lzo_crc32_slice[3][lo >> 24] ^
+              lzo_crc32_slice[2][hi & 0xff] ^ lzo_crc32_slice[1][(hi >> 8) & 0xff] ^
+              lzo_crc32_slice[0][(hi >> 16) & 0xff] ^ t0[hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    while (len > 0)
+    {
+        crc = t0[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+        len -= 1;
+    }
+    return crc;
+}
+
+#undef LZO_GET_LE32
 
+
+/***********************************************************************
+// x86: fold 64 bytes per step with carry-less multiplies (PCLMULQDQ),
+// then reduce 128 -> 32 bits with a Barrett reduction; see Intel's
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+// The constants are x^(k) mod P for the bit-reflected polynomial.
+************************************************************************/
+
+#if !defined(LZO_CFG_NO_CRC32_SIMD) && (LZO_HAVE_X86_TARGET_ATTR)
+#define LZO_CRC32_HAVE_PCLMUL 1
+#include <wmmintrin.h>
+
+/* 33-bit constants as little-endian u32 pairs, two per 128-bit lane */
+static const lzo_uint32_t lzo_crc32_fold_k[16] = {
+    0x54442bd4, 1, 0xc6e41596, 1,       /* k1, k2: fold by 512 bits */
+    0x751997d0, 1, 0xccaa009e, 0,       /* k3, k4: fold by 128 bits */
+    0x63cd6124, 1, 0, 0,                /* k5: 64 -> 32 bits */
+    0xdb710641, 1, 0xf7011641, 1        /* P', mu: Barrett reduction */
+};
+
+__attribute__((__target__("pclmul")))
+static lzo_uint32_t
+lzo_crc32_fold(lzo_uint32_t crc, const lzo_bytep buf, lzo_uint len)
+{
+    /* len >= 64 and a multiple of 16 */
+    const __m128i k1k2 = _mm_loadu_si128((const __m128i *) (lzo_crc32_fold_k + 0));
+    const __m128i k3k4 = _mm_loadu_si128((const __m128i *) (lzo_crc32_fold_k + 4));
+    const __m128i k5k0 = _mm_loadu_si128((const __m128i *) (lzo_crc32_fold_k + 8));
+    const __m128i poly = _mm_loadu_si128((const __m128i *) (lzo_crc32_fold_k + 12));
+    const __m128i mask32 = _mm_setr_epi32(-1, 0, -1, 0);
+    __m128i x1, x2, x3, x4, y1, y2, y3, y4;
+
+    x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (buf + 0x00)),
+                       _mm_cvtsi32_si128((int) crc));
+    x2 = _mm_loadu_si128((const __m128i *) (buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *) (buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *) (buf + 0x30));
+    buf += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        y1 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        y2 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        y3 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        y4 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, y1), _mm_loadu_si128((const __m128i *) (buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, y2), _mm_loadu_si128((const __m128i *) (buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, y3), _mm_loadu_si128((const __m128i *) (buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, y4), _mm_loadu_si128((const __m128i *) (buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+
+    /* fold the four lanes into one */
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), y1);
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), y1);
+    y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), y1);
+
+    while (len >= 16)
+    {
+        y1 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *) buf)), y1);
+        buf += 16;
+        len -= 16;
+    }
+
+    /* 128 -> 64 bits */
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+    /* Barrett reduction to 32 bits */
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (lzo_uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+static lzo_uint32_t
+lzo_crc32_pclmul(lzo_uint32_t crc, const lzo_bytep buf, lzo_uint len)
+{
+    if (len >= 64)
+    {
+        lzo_uint n = len & ~(lzo_uint) 15;
+        crc = lzo_crc32_fold(crc, buf, n);
+        buf += n;
+        len -= n;
+    }
+    return lzo_crc32_slice8(crc, buf, len);
+}
+#endif
+
+
+/***********************************************************************
+// ARMv8: the optional CRC32 instructions use the same polynomial
+************************************************************************/
+
+#if !defined(LZO_CFG_NO_CRC32_SIMD) && (LZO_ARCH_ARM64) && defined(UA_GET_LE64) && \
+    (defined(__ARM_FEATURE_CRC32) || \
+     (LZO_OS_POSIX_LINUX && ((LZO_CC_GNUC >= 0x0a0000ul) || (LZO_CC_CLANG >= 0x080000ul))))
+#define LZO_CRC32_HAVE_ARMV8 1
+#include <arm_acle.h>
+
+#if defined(__ARM_FEATURE_CRC32)
+#  define LZO_CRC32_ARMV8_TARGET    /*empty*/
+#elif (LZO_CC_CLANG)
+#  define LZO_CRC32_ARMV8_TARGET    __attribute__((__target__("crc")))
+#else
+#  define LZO_CRC32_ARMV8_TARGET    __attribute__((__target__("+crc")))
+#endif
+
+LZO_CRC32_ARMV8_TARGET
+static lzo_uint32_t
+lzo_crc32_armv8(lzo_uint32_t crc, const lzo_bytep buf, lzo_uint len)
+{
+    while (len > 0 && ((lzo_uintptr_t) buf & 7) != 0)
+    {
+        crc = __crc32b(crc, *buf++);
+        len -= 1;
+    }
+    while (len >= 8)
+    {
+        crc = __crc32d(crc, UA_GET_LE64(buf));
+        buf += 8;
+        len -= 8;
+    }
+    while (len > 0)
+    {
+        crc = __crc32b(crc, *buf++);
+        len -= 1;
+    }
+    return crc;
+}
+#endif
+
+
+/***********************************************************************
+// dispatch
+************************************************************************/
+
+/* the table loop until lzo_init() has picked a kernel */
+static lzo_crc32_kernel_t lzo_crc32_impl = lzo_crc32_bytewise;
+
+LZO_LOCAL_IMPL(void)
+_lzo_crc32_init(unsigned features)
+{
+    unsigned k, n;
+
+    for (n = 0; n < 256; n++)
+    {
+        lzo_uint32_t c = lzo_crc32_table[n];
+        for (k = 0; k < 7; k++)
+        {
+            c = lzo_crc32_table[c & 0xff] ^ (c >> 8);
+            lzo_crc32_slice[k][n] = c;
+        }
+    }
+    lzo_crc32_impl = lzo_crc32_slice8;
+#if defined(LZO_CRC32_HAVE_PCLMUL)
+    if ((features & (LZO_CPU_F_PCLMUL | LZO_CPU_F_SSE2)) == (LZO_CPU_F_PCLMUL | LZO_CPU_F_SSE2))
+        lzo_crc32_impl = lzo_crc32_pclmul;
+#endif
+#if defined(LZO_CRC32_HAVE_ARMV8)
+    if (features & LZO_CPU_F_ARM_CRC32)
+        lzo_crc32_impl = lzo_crc32_armv8;
+#endif
+    LZO_UNUSED(features);
+}
+
+
+LZO_PUBLIC(lzo_uint32_t)
+lzo_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len)
+{
+    lzo_uint32_t crc;
+
+    if (buf == NULL)
+        return 0;
+
+    crc = (c & LZO_UINT32_C(0xffffffff)) ^ LZO_UINT32_C(0xffffffff);
+    crc = lzo_crc32_impl(crc, buf, len);
     return crc ^ LZO_UINT32_C(0xffffffff);
-#undef table
 }
 
 #undef LZO_DO1
@@ -150,4 +378,50 @@ lzo_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len)
 #undef LZO_DO16
 
 
+/***********************************************************************
+// crc32_combine
+// combine the crc32 of two adjacent buffers given the second one's length;
+// adapted from zlib's crc32_combine(), see above
+************************************************************************/
+
+/* a * b modulo the crc32 polynomial, both in reflected bit order */
+static lzo_uint32_t
+lzo_crc32_multmodp(lzo_uint32_t a, lzo_uint32_t b)
+{
+    lzo_uint32_t m = LZO_UINT32_C(1) << 31;
+    lzo_uint32_t p = 0;
+
+    for (;;)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ LZO_UINT32_C(0xedb88320) : b >> 1;
+    }
+    return p;
+}
+
+LZO_PUBLIC(lzo_uint32_t)
+lzo_crc32_combine(lzo_uint32_t crc1, lzo_uint32_t crc2, lzo_uint len2)
+{
+    lzo_uint32_t p = LZO_UINT32_C(1) << 31;         /* x^0 */
+    lzo_uint32_t sq = LZO_UINT32_C(1) << 23;        /* x^8, one zero byte */
+
+    /* p = x^(8 * len2), one squaring per bit of len2 */
+    while (len2 != 0)
+    {
+        if (len2 & 1)
+            p = lzo_crc32_multmodp(sq, p);
+        len2 >>= 1;
+        if (len2 != 0)
+            sq = lzo_crc32_multmodp(sq, sq);
+    }
+    return lzo_crc32_multmodp(p, crc1 & LZO_UINT32_C(0xffffffff)) ^ (crc2 & LZO_UINT32_C(0xffffffff));
+}
+
+
 /* vim:set ts=4 sw=4 et: */
@@ -188,6 +188,70 @@ _lzo_config_check(void)
 }
 
 
+/***********************************************************************
+// CPU feature detection for the runtime-dispatched kernels
+************************************************************************/
+
+#if !defined(__LZO_IN_MINILZO)
+
+#if (LZO_HAVE_X86_TARGET_ATTR)
+#include <cpuid.h>
+#elif (LZO_ARCH_ARM64 && LZO_OS_POSIX_LINUX && !defined(__ARM_FEATURE_CRC32))
+#include <sys/auxv.h>
+#endif
+
+LZO_LOCAL_IMPL(unsigned)
+_lzo_cpu_features(void)
+{
+    unsigned f = 0;
+#if (LZO_HAVE_X86_TARGET_ATTR)
+    unsigned a, b, c, d;
+    if (__get_cpuid(1, &a, &b, &c, &d))
+    {
+        /* leaf 1 ecx part of x86-64-v3: SSE3 SSSE3 FMA CX16 SSE4.1 SSE4.2
+         * MOVBE POPCNT AVX F16C */
+        const unsigned v3_c1 = 0x30d83201u;
+        unsigned c1 = c;
+        if (d & (1u << 26)) f |= LZO_CPU_F_SSE2;
+        if (c & (1u << 9))  f |= LZO_CPU_F_SSSE3;
+        if (c & (1u << 1))  f |= LZO_CPU_F_PCLMUL;
+        /* AVX2 also needs the OS to save the ymm registers (OSXSAVE, XCR0) */
+        if ((c & (1u << 27)) && __get_cpuid_max(0, NULL) >= 7)
+        {
+            unsigned xlo, xhi, ea, eb, ec, ed;
+            __asm__ __volatile__("xgetbv" : "=a" (xlo), "=d" (xhi) : "c" (0));
+            LZO_UNUSED(xhi);
+            if ((xlo & 6) == 6)
+            {
+                __cpuid_count(7, 0, a, b, c, d);
+                if (b & (1u << 5)) f |= LZO_CPU_F_AVX2;
+                /* ...and leaf 7 ebx: BMI1 AVX2 BMI2, plus LZCNT */
+                if ((c1 & v3_c1) == v3_c1 && (b & 0x128u) == 0x128u &&
+                    __get_cpuid(0x80000001u, &ea, &eb, &ec, &ed) && (ec & (1u << 5)))
+                {
+                    f |= LZO_CPU_F_X86_V3;
+                    /* v4 adds AVX-512 F DQ CD BW VL and the opmask/zmm state */
+                    if ((b & 0xd0030000u) == 0xd0030000u && (xlo & 0xe6) == 0xe6)
+                        f |= LZO_CPU_F_X86_V4;
+                }
+            }
+        }
+    }
+#elif (LZO_ARCH_ARM64)
+    f |= LZO_CPU_F_NEON;
+#  if defined(__ARM_FEATURE_CRC32)
+    f |= LZO_CPU_F_ARM_CRC32;
+#  elif (LZO_OS_POSIX_LINUX)
+    if (getauxval(AT_HWCAP) & (1ul << 7))       /* HWCAP_CRC32 */
+        f |= LZO_CPU_F_ARM_CRC32;
+#  endif
+#endif
+    return f;
+}
+
+#endif /* !__LZO_IN_MINILZO */
+
+
 /***********************************************************************
 //
 ************************************************************************/
@@ -227,6 +291,17 @@ __lzo_init_v2(unsigned v, int s1, int s2, int s3, int s4, int s5,
     if (r != LZO_E_OK)
         return r;
 
+#if !defined(__LZO_IN_MINILZO)
+    {
+        unsigned features = _lzo_cpu_features();
+        _lzo_crc32_init(features);
+        _lzo_adler32_init(features);
+#if (LZO_CFG_ISA_DISPATCH)
+        _lzo1x_isa_init(features);
+#endif
+    }
+#endif
+
     return r;
 }
 
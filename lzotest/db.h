@@ -229,6 +229,12 @@
   lzo1x_decompress_asm_fast,    lzo1x_decompress_asm_fast_safe,
   0,                            0 },
 #endif
+{ "LZO1X-1(vec)", M_LZO1X_1_VEC, LZO1X_1_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+  lzo1x_1_compress,             lzo1x_optimize,
+  lzo1x_decompress_vec,         lzo1x_decompress_vec_safe,
+  0,                            0,
+  0,                            0,
+  0,                            0 },
 { "LZO1X-1(11)", M_LZO1X_1_11, LZO1X_1_11_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
   lzo1x_1_11_compress,          lzo1x_optimize,
   lzo1x_decompress,             lzo1x_decompress_safe,
@@ -307,6 +313,24 @@
   lzo1x_decompress_asm,         lzo1x_decompress_asm_safe,
   lzo1x_decompress_asm_fast,    lzo1x_decompress_asm_fast_safe,
   0,                            lzo1x_decompress_dict_safe },
+{ "LZO1X-999/10", 9730, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+  lzo1x_999_10_compress,        lzo1x_optimize,
+  lzo1x_decompress,             lzo1x_decompress_safe,
+  lzo1x_decompress_asm,         lzo1x_decompress_asm_safe,
+  lzo1x_decompress_asm_fast,    lzo1x_decompress_asm_fast_safe,
+  0,                            lzo1x_decompress_dict_safe },
+{ "LZO1X-999/ctx", 9731, 0, LZO1X_MEM_DECOMPRESS,
+  lzo1x_999_ctx_9_compress,     lzo1x_optimize,
+  lzo1x_decompress,             lzo1x_decompress_safe,
+  lzo1x_decompress_asm,         lzo1x_decompress_asm_safe,
+  lzo1x_decompress_asm_fast,    lzo1x_decompress_asm_fast_safe,
+  0,                            lzo1x_decompress_dict_safe },
+{ "LZO1X-999/tree", 9732, LZO1X_999_MEM_COMPRESS, LZO1X_MEM_DECOMPRESS,
+  lzo1x_999_tree_compress,      lzo1x_optimize,
+  lzo1x_decompress,             lzo1x_decompress_safe,
+  lzo1x_decompress_asm,         lzo1x_decompress_asm_safe,
+  lzo1x_decompress_asm_fast,    lzo1x_decompress_asm_fast_safe,
+  0,                            lzo1x_decompress_dict_safe },
 #endif
 
 #if defined(HAVE_LZO1Y_H)
@@ -466,6 +490,10 @@
                                 adler32_x_compress, 0, 0, 0, 0, 0, 0, 0 },
 { "crc32()", M_CRC32, 0, 0,     crc32_x_compress, 0,
                                 crc32_x_compress, 0, 0, 0, 0, 0, 0, 0 },
+{ "adler32_ref()", M_ADLER32_REF, 0, 0, adler32_ref_x_compress, 0,
+                                adler32_ref_x_compress, 0, 0, 0, 0, 0, 0, 0 },
+{ "crc32_ref()", M_CRC32_REF, 0, 0, crc32_ref_x_compress, 0,
+                                crc32_ref_x_compress, 0, 0, 0, 0, 0, 0, 0 },
 #if defined(ALG_ZLIB)
 { "z_adler32()", M_Z_ADLER32, 0, 0, zlib_adler32_x_compress, 0,
                                 zlib_adler32_x_compress, 0, 0, 0, 0, 0, 0, 0 },
@@ -160,6 +160,7 @@ enum {
     M_LZO1X_1_11  =   111,
     M_LZO1X_1_12  =   112,
     M_LZO1X_1_15  =   115,
+    M_LZO1X_1_VEC =   170,
     M_LZO1X_999   =   972,
     M_LZO1Y_1     =    81,
     M_LZO1Y_999   =   982,
@@ -193,6 +194,8 @@ enum {
 /* checksum algorithms - for benchmarking */
     M_ADLER32     =  6001,
     M_CRC32       =  6002,
+    M_ADLER32_REF =  6003,
+    M_CRC32_REF   =  6004,
 #if defined(ALG_ZLIB)
     M_Z_ADLER32   =  6011,
     M_Z_CRC32     =  6012,
@@ -1604,7 +1607,7 @@ static void parse_methods(const char *p)
         else if (m_strcmp(p,"ALL") == 0)
         {
             add_all_methods(1,M_LAST_COMPRESSOR);
-            add_all_methods(9721,9729);
+            add_all_methods(9721,9732);
             add_all_methods(9781,9789);
         }
         else if (m_strcmp(p,"lzo") == 0)
@@ -1618,7 +1621,7 @@ static void parse_methods(const char *p)
         else if (m_strcmp(p,"m999") == 0)
             add_methods(x999_methods);
         else if (m_strcmp(p,"1x999") == 0)
-            add_all_methods(9721,9729);
+            add_all_methods(9721,9732);
         else if (m_strcmp(p,"1y999") == 0)
             add_all_methods(9821,9829);
 #if defined(ALG_ZLIB)
@@ -2058,6 +2061,10 @@ int __lzo_cdecl_main main(int argc, char *argv[])
     if (r != EXIT_OK)
         printf("\n%s: exit code: %d\n", progname, r);
 
+#if defined(HAVE_LZO1X_H)
+    lzo1x_999_ctx_destroy(ctx_999);
+    mb_free(&ctx_mem);
+#endif
     lzo_pclock_close(&pch);
     return r;
 }
@@ -113,6 +113,63 @@ lzo1x_999_9_compress    ( const lzo_bytep src, lzo_uint  src_len,
                                     dict.ptr, dict.len, 0, 9);
 }
 
+LZO_PRIVATE(int)
+lzo1x_999_10_compress   ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_999_compress_level(src, src_len, dst, dst_len, wrkmem,
+                                    dict.ptr, dict.len, 0, 10);
+}
+
+/* level 9 with the binary tree match finder (flag 2), which has no
+ * level of its own; the prototype is private, as in precomp2.c */
+LZO_EXTERN(int)
+lzo1x_999_compress_internal ( const lzo_bytep in , lzo_uint  in_len,
+                                    lzo_bytep out, lzo_uintp out_len,
+                                    lzo_voidp wrkmem,
+                              const lzo_bytep dict, lzo_uint dict_len,
+                                    lzo_callback_p cb,
+                                    int try_lazy,
+                                    lzo_uint good_length,
+                                    lzo_uint max_lazy,
+                                    lzo_uint nice_length,
+                                    lzo_uint max_chain,
+                                    lzo_uint32_t flags );
+
+LZO_PRIVATE(int)
+lzo1x_999_tree_compress ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_999_compress_internal(src, src_len, dst, dst_len, wrkmem,
+                                       dict.ptr, dict.len, 0,
+                                       2, 2048, 2048, 0, 4096, 1 | 2);
+}
+
+/* level 9 through one lzo1x_999_ctx kept across all calls, so every
+ * block after the first runs on tables left clear by the one before;
+ * main() frees it */
+static mblock_t ctx_mem;
+static lzo1x_999_ctx_p ctx_999 = NULL;
+
+LZO_PRIVATE(int)
+lzo1x_999_ctx_9_compress ( const lzo_bytep src, lzo_uint  src_len,
+                                 lzo_bytep dst, lzo_uintp dst_len,
+                                 lzo_voidp wrkmem )
+{
+    LZO_UNUSED(wrkmem);
+    if (ctx_999 == NULL)
+    {
+        mb_alloc(&ctx_mem, LZO1X_999_CTX_MEM_SIZE);
+        ctx_999 = lzo1x_999_ctx_create(ctx_mem.ptr, 9);
+        if (ctx_999 == NULL)
+            return LZO_E_ERROR;
+    }
+    return lzo1x_999_ctx_compress(ctx_999, src, src_len, dst, dst_len,
+                                  dict.ptr, dict.len);
+}
+
 #endif
 
 
@@ -260,4 +317,52 @@ crc32_x_compress        ( const lzo_bytep src, lzo_uint  src_len,
 }
 
 
+/* plain byte-at-a-time loops, the baseline for the library's kernels;
+ * results go to a volatile so the loops cannot be optimized away */
+
+static volatile lzo_uint32_t checksum_ref_result;
+
+LZO_PRIVATE(int)
+adler32_ref_x_compress  ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem )
+{
+    lzo_uint32_t s1 = 1, s2 = 0;
+    lzo_uint n = src_len;
+    const lzo_bytep p = dst;
+    while (n > 0)
+    {
+        lzo_uint k = n < 5552 ? n : 5552;
+        n -= k;
+        do {
+            s1 += *p++;
+            s2 += s1;
+        } while (--k > 0);
+        s1 %= 65521u;
+        s2 %= 65521u;
+    }
+    checksum_ref_result = (s2 << 16) | s1;
+    *dst_len = src_len;
+    LZO_UNUSED(src); LZO_UNUSED(wrkmem);
+    return 0;
+}
+
+
+LZO_PRIVATE(int)
+crc32_ref_x_compress    ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem )
+{
+    const lzo_uint32_tp table = lzo_get_crc32_table();
+    lzo_uint32_t crc = 0xffffffffUL;
+    lzo_uint n;
+    for (n = 0; n < src_len; n++)
+        crc = table[(crc ^ dst[n]) & 0xff] ^ (crc >> 8);
+    checksum_ref_result = ~crc & 0xffffffffUL;
+    *dst_len = src_len;
+    LZO_UNUSED(src); LZO_UNUSED(wrkmem);
+    return 0;
+}
+
+
 /* vim:set ts=4 sw=4 et: */
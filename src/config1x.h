@@ -100,6 +100,39 @@
 
 
 
+/***********************************************************************
+// LZO1X-1 codecs per x86-64 ISA level, see lzo1x_isa.c
+************************************************************************/
+
+#if (LZO_CFG_ISA_DISPATCH)
+#define LZO1X_ISA_DECL(f) \
+    LZO_LOCAL_DECL(int) f (const lzo_bytep in, lzo_uint in_len, \
+                           lzo_bytep out, lzo_uintp out_len, lzo_voidp wrkmem)
+LZO1X_ISA_DECL(_lzo1x_1_compress_v1);
+LZO1X_ISA_DECL(_lzo1x_decompress_v1);
+LZO1X_ISA_DECL(_lzo1x_decompress_safe_v1);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_v1);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_safe_v1);
+LZO1X_ISA_DECL(_lzo1x_1_compress_v3);
+LZO1X_ISA_DECL(_lzo1x_decompress_v3);
+LZO1X_ISA_DECL(_lzo1x_decompress_safe_v3);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_v3);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_safe_v3);
+LZO1X_ISA_DECL(_lzo1x_1_compress_v4);
+LZO1X_ISA_DECL(_lzo1x_decompress_v4);
+LZO1X_ISA_DECL(_lzo1x_decompress_safe_v4);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_v4);
+LZO1X_ISA_DECL(_lzo1x_decompress_vec_safe_v4);
+#define LZO1X_ISA_DECL_ACCEL(f) \
+    LZO_LOCAL_DECL(int) f (const lzo_bytep in, lzo_uint in_len, \
+                           lzo_bytep out, lzo_uintp out_len, lzo_voidp wrkmem, \
+                           int accel)
+LZO1X_ISA_DECL_ACCEL(_lzo1x_1_compress_accel_v1);
+LZO1X_ISA_DECL_ACCEL(_lzo1x_1_compress_accel_v3);
+LZO1X_ISA_DECL_ACCEL(_lzo1x_1_compress_accel_v4);
+#endif
+
+
 #endif /* already included */
 
 
@@ -49,7 +49,15 @@
 #define LZO_DETERMINISTIC !(LZO_DICT_USE_PTR)
 
 #ifndef DO_COMPRESS
+#if (LZO_CFG_ISA_DISPATCH)
+/* the x86-64 baseline build, see lzo1x_isa.c */
+#define DO_LINKAGE(r)   LZO_LOCAL_IMPL(r)
+#define DO_COMPRESS     _lzo1x_1_compress_v1
+#define DO_COMPRESS_ACCEL _lzo1x_1_compress_accel_v1
+#else
 #define DO_COMPRESS     lzo1x_1_compress
+#define DO_COMPRESS_ACCEL lzo1x_1_compress_accel
+#endif
 #endif
 
 #include "lzo1x_c.ch"
@@ -50,6 +50,7 @@
 #define SWD_F            2048           /* upper limit for match length */
 
 #define SWD_BEST_OFF    (LZO_MAX3( M2_MAX_LEN, M3_MAX_LEN, M4_MAX_LEN ) + 1)
+#define SWD_CLEAR_NODES  2048           /* see lzo1x_999_ctx_compress() */
 
 #if defined(LZO1X)
 #  define LZO_COMPRESS_T                lzo1x_999_t
@@ -85,6 +86,10 @@
 
 
 /* this is a public functions, but there is no prototype in a header file */
+/* flags: 1 = keep the best offset per match length (SWD_BEST_OFF),
+ *        2 = binary tree match finder instead of hash chains,
+ *        4 = optimal parsing instead of lazy matching,
+ *        8 = the SWD tables in wrkmem are clear; leave them clear */
 LZO_EXTERN(int)
 lzo1x_999_compress_internal ( const lzo_bytep in , lzo_uint  in_len,
                                     lzo_bytep out, lzo_uintp out_len,
@@ -513,6 +518,198 @@ better_match ( const lzo_swd_p swd, lzo_uint *m_len, lzo_uint *m_off )
 #endif
 
 
+/***********************************************************************
+// optimal parsing
+//
+// Instead of choosing between the current match and a lazy one, a
+// stretch of input is parsed as a shortest path: node[k] holds the
+// cheapest known coding of the k bytes after the window start, in
+// output bytes. A literal costs its byte plus the growth of the run
+// length field, a match costs len_of_coded_match() for the run in front
+// of it. Every length of a match is tried, each with the nearest offset
+// from the best_off table.
+//
+// A window ends at a position no pending edge jumps over (its path is
+// then optimal), after OPT_NUM positions, or at a match of at least
+// OPT_NICE bytes, which is coded as is. The nodes live on the stack.
+************************************************************************/
+
+#if defined(SWD_BEST_OFF)
+
+#define OPT_NUM         1024
+#define OPT_NICE         128
+
+typedef struct
+{
+    lzo_uint lit;           /* length of the literal run ending here */
+    lzo_uint32_t price;     /* output bytes since the window start */
+    lzo_uint16_t len;       /* edge into this position, 0 = literal */
+    lzo_uint16_t off;
+}
+lzo_opt_t;
+
+
+/* bytes for the length field of a literal run */
+static lzo_uint
+len_of_coded_run ( lzo_uint t, lzo_bool first )
+{
+    if (t == 0)
+        return 0;
+    if (first && t <= 238)
+        return 1;
+    if (t <= 3)
+        return 0;
+    if (t <= 18)
+        return 1;
+    return 2 + (t - 19) / 255;
+}
+
+
+static lzo_bytep
+optimal_parse ( LZO_COMPRESS_T *c, lzo_swd_p swd, lzo_bytep op,
+                const lzo_bytep *iip, lzo_uint *litp )
+{
+    lzo_opt_t node[ OPT_NUM + OPT_NICE ];
+    const lzo_bytep ii = *iip;
+    lzo_uint lit = *litp;
+    lzo_uint k, i;
+    int r;
+
+    while (c->look > 0)
+    {
+        const lzo_bytep const bp = c->bp;
+        const lzo_bool first = (op == c->out);
+        lzo_uint reach = 0;
+
+        node[0].lit = lit;
+        node[0].price = 0;
+        node[0].len = 0;
+        node[0].off = 0;
+
+        /* forward pass */
+        for (k = 0; c->look > 0; )
+        {
+            const lzo_uint l_lit = node[k].lit;
+            /* no match coded yet on this path */
+            const lzo_bool f = first && l_lit == lit + k;
+            lzo_uint m_len = c->m_len;
+            lzo_uint m_off = c->m_off;
+            lzo_uint32_t price;
+
+            if (m_len >= OPT_NICE && !(f && l_lit == 0))
+                break;
+
+            if (reach < k + 1)
+                node[++reach].price = ~(lzo_uint32_t) 0;
+            price = node[k].price + 1 + len_of_coded_run(l_lit + 1, f)
+                                      - len_of_coded_run(l_lit, f);
+            /* on a tie keep a run of four or more literals going: a
+             * match would make the literals after it pay for a new
+             * run length field */
+            if (price < node[k + 1].price ||
+                (price == node[k + 1].price && l_lit >= 3))
+            {
+                node[k + 1].lit = l_lit + 1;
+                node[k + 1].price = price;
+                node[k + 1].len = 0;
+            }
+
+            /* as in the lazy loop below: no match before the first
+             * literal, no M1 match right after the first literal run */
+            if (m_len >= 2 && !(f && l_lit == 0))
+            {
+                assert(m_len < OPT_NICE);
+                for (i = m_len; i >= (f ? 3u : 2u); i--)
+                {
+                    lzo_uint n;
+
+                    if (i < SWD_BEST_OFF && swd->use_best_off &&
+                        swd->best_off[i] > 0 && swd->best_off[i] < m_off)
+                        m_off = swd->best_off[i];
+                    n = len_of_coded_match(i, m_off, l_lit);
+                    if (n == 0)
+                        continue;
+                    while (reach < k + i)
+                        node[++reach].price = ~(lzo_uint32_t) 0;
+                    price = node[k].price + (lzo_uint32_t) n;
+                    if (price < node[k + i].price)
+                    {
+                        node[k + i].lit = 0;
+                        node[k + i].price = price;
+                        node[k + i].len = (lzo_uint16_t) i;
+                        node[k + i].off = (lzo_uint16_t) m_off;
+                    }
+                }
+            }
+
+            r = find_match(c,swd,1,0);
+            assert(r == 0); LZO_UNUSED(r);
+            if (++k == reach || k == OPT_NUM)
+                break;
+        }
+
+        /* turn the edges around so that each node holds the next one */
+        if (k > 0)
+        {
+            lzo_uint len = node[k].len, off = node[k].off;
+
+            i = k;
+            while (i > 0)
+            {
+                lzo_uint j = i - (len > 0 ? len : 1);
+                lzo_uint t_len = node[j].len, t_off = node[j].off;
+
+                node[j].len = (lzo_uint16_t) len;
+                node[j].off = (lzo_uint16_t) off;
+                len = t_len; off = t_off;
+                i = j;
+            }
+        }
+
+        /* code the path */
+        for (i = 0; i < k; )
+        {
+            lzo_uint len = node[i].len;
+
+            if (len == 0)
+            {
+                if (lit == 0)
+                    ii = bp + i;
+                lit++;
+                i++;
+            }
+            else
+            {
+                op = code_run(c,op,ii,lit,len);
+                lit = 0;
+                op = code_match(c,op,len,node[i].off);
+                i += len;
+            }
+        }
+        assert(i == k);
+        c->codesize = pd(op, c->out);
+
+        /* take a long match directly */
+        if (c->look > 0 && c->m_len >= OPT_NICE && (lit > 0 || op != c->out))
+        {
+            lzo_uint m_len = c->m_len;
+
+            op = code_run(c,op,ii,lit,m_len);
+            lit = 0;
+            op = code_match(c,op,m_len,c->m_off);
+            r = find_match(c,swd,m_len,1);
+            assert(r == 0); LZO_UNUSED(r);
+        }
+    }
+
+    *iip = ii;
+    *litp = lit;
+    return op;
+}
+
+#endif
+
+
 /***********************************************************************
 //
 ************************************************************************/
@@ -593,6 +790,10 @@ lzo1x_999_compress_internal ( const lzo_bytep in , lzo_uint  in_len,
     r = find_match(c,swd,0,0);
     if (r != 0)
         return r;
+#if defined(SWD_BEST_OFF)
+    if (flags & 4)
+        op = optimal_parse(c,swd,op,&ii,&lit);
+#endif
     while (c->look > 0)
     {
         lzo_uint ahead;
@@ -783,6 +984,11 @@ lazy_match_done: ;
 #endif
     assert(c->lit_bytes + c->match_bytes == in_len);
 
+#if !defined(__LZO_CHECKER)
+    if (flags & 8)
+        swd_clear_nodes(swd, swd->dict_len + in_len);
+#endif
+
     return LZO_E_OK;
 }
 
@@ -791,13 +997,14 @@ lazy_match_done: ;
 //
 ************************************************************************/
 
-LZO_PUBLIC(int)
-lzo1x_999_compress_level    ( const lzo_bytep in , lzo_uint  in_len,
-                                    lzo_bytep out, lzo_uintp out_len,
-                                    lzo_voidp wrkmem,
-                              const lzo_bytep dict, lzo_uint dict_len,
-                                    lzo_callback_p cb,
-                                    int compression_level )
+static int
+compress_level  ( const lzo_bytep in , lzo_uint  in_len,
+                        lzo_bytep out, lzo_uintp out_len,
+                        lzo_voidp wrkmem,
+                  const lzo_bytep dict, lzo_uint dict_len,
+                        lzo_callback_p cb,
+                        int compression_level,
+                        lzo_uint32_t flags )
 {
     static const struct
     {
@@ -807,7 +1014,7 @@ lzo1x_999_compress_level    ( const lzo_bytep in , lzo_uint  in_len,
         lzo_uint nice_length;
         lzo_uint max_chain;
         lzo_uint32_t flags;
-    } c[9] = {
+    } c[10] = {
         /* faster compression */
         {   0,     0,     0,     8,    4,   0 },
         {   0,     0,     0,    16,    8,   0 },
@@ -817,11 +1024,13 @@ lzo1x_999_compress_level    ( const lzo_bytep in , lzo_uint  in_len,
         {   1,     8,    16,   128,  128,   0 },
         {   2,     8,    32,   128,  256,   0 },
         {   2,    32,   128, SWD_F, 2048,   1 },
-        {   2, SWD_F, SWD_F, SWD_F, 4096,   1 }
+        {   2, SWD_F, SWD_F, SWD_F, 4096,   1 },
         /* max. compression */
+        {   0,     0,     0, SWD_F, 4096,   5 }
+        /* optimal parsing, slower still */
     };
 
-    if (compression_level < 1 || compression_level > 9)
+    if (compression_level < 1 || compression_level > 10)
         return LZO_E_ERROR;
 
     compression_level -= 1;
@@ -836,7 +1045,20 @@ lzo1x_999_compress_level    ( const lzo_bytep in , lzo_uint  in_len,
                                        0,
 #endif
                                        c[compression_level].max_chain,
-                                       c[compression_level].flags);
+                                       c[compression_level].flags | flags);
+}
+
+
+LZO_PUBLIC(int)
+lzo1x_999_compress_level    ( const lzo_bytep in , lzo_uint  in_len,
+                                    lzo_bytep out, lzo_uintp out_len,
+                                    lzo_voidp wrkmem,
+                              const lzo_bytep dict, lzo_uint dict_len,
+                                    lzo_callback_p cb,
+                                    int compression_level )
+{
+    return compress_level(in, in_len, out, out_len, wrkmem,
+                          dict, dict_len, cb, compression_level, 0);
 }
 
 
@@ -864,4 +1086,70 @@ lzo1x_999_compress  ( const lzo_bytep in , lzo_uint  in_len,
 }
 
 
+/***********************************************************************
+// reusable context
+//
+// swd_init() clears 160 kB of llen3 and head2 on every call, which
+// dominates small blocks. A context is created clear and every call
+// leaves it clear again, undoing only the keys of the nodes it inserted
+// (swd_clear_nodes()), so later calls skip the memset.
+************************************************************************/
+
+#if defined(LZO1X)
+
+struct lzo1x_999_ctx_t
+{
+    lzo_swd_t swd;
+    int level;
+};
+
+LZO_PUBLIC(lzo1x_999_ctx_p)
+lzo1x_999_ctx_create ( lzo_voidp mem, int compression_level )
+{
+    lzo1x_999_ctx_p ctx = (lzo1x_999_ctx_p) mem;
+
+    LZO_COMPILE_TIME_ASSERT(LZO1X_999_CTX_MEM_SIZE >= sizeof(*ctx))
+
+    if (ctx == NULL)
+        return ctx;
+    ctx->level = 0;
+    if (lzo1x_999_ctx_reset(ctx, compression_level) != LZO_E_OK)
+        return NULL;
+    return ctx;
+}
+
+LZO_PUBLIC(int)
+lzo1x_999_ctx_reset ( lzo1x_999_ctx_p ctx, int compression_level )
+{
+    if (ctx == NULL || compression_level < 1 || compression_level > 10)
+        return LZO_E_ERROR;
+#if !defined(__LZO_CHECKER)
+    swd_clear_tables(&ctx->swd);
+#endif
+    ctx->level = compression_level;
+    return LZO_E_OK;
+}
+
+LZO_PUBLIC(int)
+lzo1x_999_ctx_compress ( lzo1x_999_ctx_p ctx,
+                         const lzo_bytep in , lzo_uint  in_len,
+                               lzo_bytep out, lzo_uintp out_len,
+                         const lzo_bytep dict, lzo_uint dict_len )
+{
+    if (ctx == NULL || ctx->level == 0)
+        return LZO_E_ERROR;
+    return compress_level(in, in_len, out, out_len, &ctx->swd,
+                          dict, dict_len, (lzo_callback_p) 0, ctx->level, 8);
+}
+
+LZO_PUBLIC(void)
+lzo1x_999_ctx_destroy ( lzo1x_999_ctx_p ctx )
+{
+    if (ctx != NULL)
+        ctx->level = 0;
+}
+
+#endif
+
+
 /* vim:set ts=4 sw=4 et: */
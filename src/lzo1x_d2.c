@@ -29,7 +29,13 @@
 #include "config1x.h"
 
 #define LZO_TEST_OVERRUN 1
+#if (LZO_CFG_ISA_DISPATCH)
+/* the x86-64 baseline build, see lzo1x_isa.c */
+#define DO_LINKAGE(r)       LZO_LOCAL_IMPL(r)
+#define DO_DECOMPRESS       _lzo1x_decompress_safe_v1
+#else
 #define DO_DECOMPRESS       lzo1x_decompress_safe
+#endif
 
 #include "lzo1x_d.ch"
 
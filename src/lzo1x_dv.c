@@ -0,0 +1,44 @@
+/* lzo1x_dv.c -- LZO1X decompression with vector copies
+
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+
+#include "config1x.h"
+
+#undef LZO_TEST_OVERRUN
+#define LZO_DECOMPRESS_VEC 1
+#if (LZO_CFG_ISA_DISPATCH)
+/* the x86-64 baseline build, see lzo1x_isa.c */
+#define DO_LINKAGE(r)       LZO_LOCAL_IMPL(r)
+#define DO_DECOMPRESS       _lzo1x_decompress_vec_v1
+#else
+#define DO_DECOMPRESS       lzo1x_decompress_vec
+#endif
+
+#include "lzo1x_d.ch"
+
+/* vim:set ts=4 sw=4 et: */
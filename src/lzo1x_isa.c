@@ -0,0 +1,144 @@
+/* lzo1x_isa.c -- runtime ISA dispatch for the LZO1X-1 codecs
+
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+#include "config1x.h"
+
+#if (LZO_CFG_ISA_DISPATCH)
+
+/***********************************************************************
+// lzo1x_1_compress*() and the lzo1x_decompress*() functions exist in
+// three builds: the x86-64 baseline (lzo1x_1.c, lzo1x_d1.c, lzo1x_d2.c,
+// lzo1x_dv.c, lzo1x_dv2.c) and the v3 and v4 levels (lzo1x_isa3.c,
+// lzo1x_isa4.c).
+// lzo_init() switches to the best level the CPU supports; until then
+// the baseline is used. All builds produce identical output.
+//
+// "#pragma GCC target" also defines __AVX2__, __BMI2__ and so on, so
+// ISA-specific paths in lzo1x_c.ch and lzo1x_d.ch are picked up by the
+// v3 and v4 builds without further changes here.
+************************************************************************/
+
+typedef int
+(__LZO_CDECL *lzo1x_accel_compress_t)
+                        ( const lzo_bytep src, lzo_uint  src_len,
+                                lzo_bytep dst, lzo_uintp dst_len,
+                                lzo_voidp wrkmem, int accel );
+
+static struct
+{
+    lzo_compress_t      compress_1;
+    lzo1x_accel_compress_t compress_1_accel;
+    lzo_decompress_t    decompress;
+    lzo_decompress_t    decompress_safe;
+    lzo_decompress_t    decompress_vec;
+    lzo_decompress_t    decompress_vec_safe;
+} lzo1x_isa = {
+    _lzo1x_1_compress_v1, _lzo1x_1_compress_accel_v1,
+    _lzo1x_decompress_v1, _lzo1x_decompress_safe_v1,
+    _lzo1x_decompress_vec_v1, _lzo1x_decompress_vec_safe_v1
+};
+
+LZO_LOCAL_IMPL(void)
+_lzo1x_isa_init(unsigned features)
+{
+    if (features & LZO_CPU_F_X86_V4)
+    {
+        lzo1x_isa.compress_1 = _lzo1x_1_compress_v4;
+        lzo1x_isa.compress_1_accel = _lzo1x_1_compress_accel_v4;
+        lzo1x_isa.decompress = _lzo1x_decompress_v4;
+        lzo1x_isa.decompress_safe = _lzo1x_decompress_safe_v4;
+        lzo1x_isa.decompress_vec = _lzo1x_decompress_vec_v4;
+        lzo1x_isa.decompress_vec_safe = _lzo1x_decompress_vec_safe_v4;
+    }
+    else if (features & LZO_CPU_F_X86_V3)
+    {
+        lzo1x_isa.compress_1 = _lzo1x_1_compress_v3;
+        lzo1x_isa.compress_1_accel = _lzo1x_1_compress_accel_v3;
+        lzo1x_isa.decompress = _lzo1x_decompress_v3;
+        lzo1x_isa.decompress_safe = _lzo1x_decompress_safe_v3;
+        lzo1x_isa.decompress_vec = _lzo1x_decompress_vec_v3;
+        lzo1x_isa.decompress_vec_safe = _lzo1x_decompress_vec_safe_v3;
+    }
+}
+
+
+/***********************************************************************
+// public entry points
+************************************************************************/
+
+LZO_PUBLIC(int)
+lzo1x_1_compress        ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_isa.compress_1(in, in_len, out, out_len, wrkmem);
+}
+
+LZO_PUBLIC(int)
+lzo1x_1_compress_accel  ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem, int accel )
+{
+    return lzo1x_isa.compress_1_accel(in, in_len, out, out_len, wrkmem, accel);
+}
+
+LZO_PUBLIC(int)
+lzo1x_decompress        ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_isa.decompress(in, in_len, out, out_len, wrkmem);
+}
+
+LZO_PUBLIC(int)
+lzo1x_decompress_safe   ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_isa.decompress_safe(in, in_len, out, out_len, wrkmem);
+}
+
+LZO_PUBLIC(int)
+lzo1x_decompress_vec    ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_isa.decompress_vec(in, in_len, out, out_len, wrkmem);
+}
+
+LZO_PUBLIC(int)
+lzo1x_decompress_vec_safe ( const lzo_bytep in , lzo_uint  in_len,
+                                lzo_bytep out, lzo_uintp out_len,
+                                lzo_voidp wrkmem )
+{
+    return lzo1x_isa.decompress_vec_safe(in, in_len, out, out_len, wrkmem);
+}
+
+#endif /* LZO_CFG_ISA_DISPATCH */
+
+/* vim:set ts=4 sw=4 et: */
@@ -0,0 +1,69 @@
+/* lzo1x_isa3.c -- LZO1X-1 codecs built for x86-64-v3
+
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+/* The same sources as lzo1x_1.c, lzo1x_d1.c, lzo1x_dv.c, lzo1x_d2.c and
+ * lzo1x_dv2.c, compiled for the x86-64-v3 level (AVX2, BMI1/2, FMA, LZCNT, MOVBE).
+ * lzo1x_isa.c only selects these when _lzo_cpu_features() reports that
+ * level.
+ */
+
+#include "lzo_conf.h"
+
+#if (LZO_CFG_ISA_DISPATCH)
+
+#pragma GCC target("sse3,ssse3,sse4.1,sse4.2,popcnt,cx16,avx,avx2,bmi,bmi2,f16c,fma,lzcnt,movbe,xsave")
+
+#define DO_LINKAGE(r)       LZO_LOCAL_IMPL(r)
+#define DO_COMPRESS         _lzo1x_1_compress_v3
+#define DO_COMPRESS_ACCEL   _lzo1x_1_compress_accel_v3
+#include "lzo1x_1.c"
+
+#undef LZO_TEST_OVERRUN
+#define DO_DECOMPRESS       _lzo1x_decompress_v3
+#include "lzo1x_d.ch"
+
+#undef DO_DECOMPRESS
+#define LZO_DECOMPRESS_VEC 1
+#define DO_DECOMPRESS       _lzo1x_decompress_vec_v3
+#include "lzo1x_d.ch"
+
+/* the safe builds last, as lzo1_d.ch keeps the overrun settings once defined */
+#undef DO_DECOMPRESS
+#undef LZO_DECOMPRESS_VEC
+#define LZO_TEST_OVERRUN 1
+#define DO_DECOMPRESS       _lzo1x_decompress_safe_v3
+#include "lzo1x_d.ch"
+
+#undef DO_DECOMPRESS
+#define LZO_DECOMPRESS_VEC 1
+#define DO_DECOMPRESS       _lzo1x_decompress_vec_safe_v3
+#include "lzo1x_d.ch"
+
+#endif /* LZO_CFG_ISA_DISPATCH */
+
+/* vim:set ts=4 sw=4 et: */
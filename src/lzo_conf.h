@@ -403,6 +403,35 @@ LZO_COMPILE_TIME_ASSERT_HEADER(sizeof(lzo_uint64_t) == 8)
 
 LZO_EXTERN(const lzo_bytep) lzo_copyright(void);
 
+/* CPU features for the runtime-dispatched kernels, see _lzo_cpu_features() */
+#define LZO_CPU_F_SSE2          0x0001u
+#define LZO_CPU_F_SSSE3         0x0002u
+#define LZO_CPU_F_PCLMUL        0x0004u
+#define LZO_CPU_F_AVX2          0x0008u
+#define LZO_CPU_F_X86_V3        0x0010u     /* all of the x86-64-v3 level */
+#define LZO_CPU_F_X86_V4        0x0020u     /* all of the x86-64-v4 level */
+#define LZO_CPU_F_NEON          0x0100u
+#define LZO_CPU_F_ARM_CRC32     0x0200u
+
+/* x86 compilers that build per-function ISA variants via target attributes */
+#if (LZO_ARCH_AMD64 || LZO_ARCH_I386) && \
+    ((LZO_CC_GNUC >= 0x040900ul) || (LZO_CC_CLANG >= 0x030800ul))
+#  define LZO_HAVE_X86_TARGET_ATTR 1
+#endif
+
+/* LZO1X-1 codecs built per x86-64 ISA level, see lzo1x_isa.c; needs
+ * "#pragma GCC target" */
+#if (LZO_ARCH_AMD64) && (LZO_CC_GNUC >= 0x050000ul) && \
+    !defined(LZO_CFG_NO_ISA_DISPATCH) && !defined(__LZO_IN_MINILZO)
+#  define LZO_CFG_ISA_DISPATCH 1
+#endif
+
+LZO_LOCAL_DECL(unsigned) _lzo_cpu_features(void);
+/* pick the kernels for the given features; called by lzo_init() */
+LZO_LOCAL_DECL(void) _lzo_crc32_init(unsigned features);
+LZO_LOCAL_DECL(void) _lzo_adler32_init(unsigned features);
+LZO_LOCAL_DECL(void) _lzo1x_isa_init(unsigned features);
+
 #include "lzo_ptr.h"
 
 /* Generate compressed data in a deterministic way.
@@ -486,6 +486,19 @@ lzo_unused_funcs_impl(void, lzo_memops_unused_funcs)(void)
     LZO_UNUSED_FUNC(lzo_memops_put_ne32);
 }
 
+
+/***********************************************************************
+// prefetch
+************************************************************************/
+
+#if !defined(lzo_prefetch)
+#if (LZO_CC_CLANG || (LZO_CC_GNUC >= 0x030200ul) || LZO_CC_INTELC_GNUC || LZO_CC_LLVM)
+#  define lzo_prefetch(p)       __builtin_prefetch((const void *) (p))
+#else
+#  define lzo_prefetch(p)       ((void) 0)
+#endif
+#endif
+
 #endif /* already included */
 
 /* vim:set ts=4 sw=4 et: */
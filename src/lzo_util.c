@@ -107,16 +107,16 @@ _lzo_version_date(void)
 #define LZO_DO8(buf,i)  LZO_DO4(buf,i); LZO_DO4(buf,i+4)
 #define LZO_DO16(buf,i) LZO_DO8(buf,i); LZO_DO8(buf,i+8)
 
-LZO_PUBLIC(lzo_uint32_t)
-lzo_adler32(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+/* all kernels take and return (s2 << 16) | s1 */
+typedef lzo_uint32_t (*lzo_adler32_kernel_t)(lzo_uint32_t, const lzo_bytep, lzo_uint);
+
+static lzo_uint32_t
+lzo_adler32_scalar(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
 {
     lzo_uint32_t s1 = adler & 0xffff;
     lzo_uint32_t s2 = (adler >> 16) & 0xffff;
     unsigned k;
 
-    if (buf == NULL)
-        return 1;
-
     while (len > 0)
     {
         k = len < LZO_NMAX ? (unsigned) len : LZO_NMAX;
@@ -138,6 +138,205 @@ lzo_adler32(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
     return (s2 << 16) | s1;
 }
 
+
+/***********************************************************************
+// x86 SSSE3 and AVX2: per step of B bytes, s1 gains the byte sum (psadbw)
+// and s2 gains the bytes weighted B..1 (pmaddubsw) plus B times the s1
+// of all earlier steps, which is kept in v_ps and scaled at the end.
+// Steps are grouped so that at most LZO_NMAX bytes pass per reduction;
+// the tail goes through the scalar loop.
+************************************************************************/
+
+#if !defined(LZO_CFG_NO_ADLER32_SIMD) && (LZO_HAVE_X86_TARGET_ATTR)
+#define LZO_ADLER32_HAVE_X86 1
+#include <immintrin.h>
+
+__attribute__((__target__("ssse3")))
+static lzo_uint32_t
+lzo_adler32_ssse3(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+{
+    const __m128i tap1 = _mm_setr_epi8(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17);
+    const __m128i tap2 = _mm_setr_epi8(16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    lzo_uint32_t s1 = adler & 0xffff;
+    lzo_uint32_t s2 = (adler >> 16) & 0xffff;
+    lzo_uint blocks = len / 32;
+
+    while (blocks > 0)
+    {
+        unsigned n = LZO_NMAX / 32;
+        __m128i v_ps, v_s1, v_s2;
+        if (n > blocks)
+            n = (unsigned) blocks;
+        blocks -= n;
+        v_ps = _mm_cvtsi32_si128((int) (s1 * n));
+        v_s1 = _mm_setzero_si128();
+        v_s2 = _mm_cvtsi32_si128((int) s2);
+        do {
+            __m128i b1 = _mm_loadu_si128((const __m128i *) buf);
+            __m128i b2 = _mm_loadu_si128((const __m128i *) (buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b1, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+            buf += 32;
+        } while (--n > 0);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1,0,3,2)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2,3,0,1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1,0,3,2)));
+        s1 = (s1 + (lzo_uint32_t) _mm_cvtsi128_si32(v_s1)) % LZO_BASE;
+        s2 = (lzo_uint32_t) _mm_cvtsi128_si32(v_s2) % LZO_BASE;
+    }
+    return lzo_adler32_scalar((s2 << 16) | s1, buf, len % 32);
+}
+
+__attribute__((__target__("avx2")))
+static lzo_uint32_t
+lzo_adler32_avx2(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+{
+    const __m256i tap1 = _mm256_setr_epi8(64,63,62,61,60,59,58,57,56,55,54,53,52,51,50,49,48,47,46,45,44,43,42,41,40,39,38,37,36,35,34,33);
+    const __m256i tap2 = _mm256_setr_epi8(32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    lzo_uint32_t s1 = adler & 0xffff;
+    lzo_uint32_t s2 = (adler >> 16) & 0xffff;
+    lzo_uint blocks = len / 64;
+
+    while (blocks > 0)
+    {
+        unsigned n = LZO_NMAX / 64;
+        __m256i v_ps, v_s1, v_s2;
+        __m128i x_s1, x_s2;
+        if (n > blocks)
+            n = (unsigned) blocks;
+        blocks -= n;
+        v_ps = _mm256_setr_epi32((int) (s1 * n), 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = _mm256_setzero_si256();
+        v_s2 = _mm256_setr_epi32((int) s2, 0, 0, 0, 0, 0, 0, 0);
+        do {
+            __m256i b1 = _mm256_loadu_si256((const __m256i *) buf);
+            __m256i b2 = _mm256_loadu_si256((const __m256i *) (buf + 32));
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b1, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b1, tap1), ones));
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b2, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b2, tap2), ones));
+            buf += 64;
+        } while (--n > 0);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 6));
+        x_s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+        x_s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+        x_s1 = _mm_add_epi32(x_s1, _mm_shuffle_epi32(x_s1, _MM_SHUFFLE(1,0,3,2)));
+        x_s2 = _mm_add_epi32(x_s2, _mm_shuffle_epi32(x_s2, _MM_SHUFFLE(2,3,0,1)));
+        x_s2 = _mm_add_epi32(x_s2, _mm_shuffle_epi32(x_s2, _MM_SHUFFLE(1,0,3,2)));
+        s1 = (s1 + (lzo_uint32_t) _mm_cvtsi128_si32(x_s1)) % LZO_BASE;
+        s2 = (lzo_uint32_t) _mm_cvtsi128_si32(x_s2) % LZO_BASE;
+    }
+    return lzo_adler32_scalar((s2 << 16) | s1, buf, len % 64);
+}
+#endif
+
+
+/***********************************************************************
+// ARM64 NEON: per 32-byte step, s1 gains the widened byte sums and v_s2
+// the s1 of all earlier steps; per-column byte sums are weighted 32..1
+// into s2 once per group.
+************************************************************************/
+
+#if !defined(LZO_CFG_NO_ADLER32_SIMD) && (LZO_ARCH_ARM64) && defined(__ARM_NEON)
+#define LZO_ADLER32_HAVE_NEON 1
+#include <arm_neon.h>
+
+static const uint16_t lzo_adler32_neon_taps[32] = {
+    32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,
+    16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1
+};
+
+static lzo_uint32_t
+lzo_adler32_neon(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+{
+    lzo_uint32_t s1 = adler & 0xffff;
+    lzo_uint32_t s2 = (adler >> 16) & 0xffff;
+    lzo_uint blocks = len / 32;
+
+    while (blocks > 0)
+    {
+        unsigned n = LZO_NMAX / 32;
+        uint32x4_t v_s1 = vdupq_n_u32(0);
+        uint32x4_t v_s2 = vsetq_lane_u32(0, vdupq_n_u32(0), 0);
+        uint16x8_t c1 = vdupq_n_u16(0), c2 = vdupq_n_u16(0);
+        uint16x8_t c3 = vdupq_n_u16(0), c4 = vdupq_n_u16(0);
+        uint32x2_t t1, t2, t;
+        if (n > blocks)
+            n = (unsigned) blocks;
+        blocks -= n;
+        v_s2 = vsetq_lane_u32(s1 * n, v_s2, 0);
+        do {
+            uint8x16_t b1 = vld1q_u8((const uint8_t *) buf);
+            uint8x16_t b2 = vld1q_u8((const uint8_t *) (buf + 16));
+            v_s2 = vaddq_u32(v_s2, v_s1);
+            v_s1 = vpadalq_u16(v_s1, vpadalq_u8(vpaddlq_u8(b1), b2));
+            c1 = vaddw_u8(c1, vget_low_u8(b1));
+            c2 = vaddw_u8(c2, vget_high_u8(b1));
+            c3 = vaddw_u8(c3, vget_low_u8(b2));
+            c4 = vaddw_u8(c4, vget_high_u8(b2));
+            buf += 32;
+        } while (--n > 0);
+        v_s2 = vshlq_n_u32(v_s2, 5);
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(c1),  vld1_u16(lzo_adler32_neon_taps + 0));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(c1), vld1_u16(lzo_adler32_neon_taps + 4));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(c2),  vld1_u16(lzo_adler32_neon_taps + 8));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(c2), vld1_u16(lzo_adler32_neon_taps + 12));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(c3),  vld1_u16(lzo_adler32_neon_taps + 16));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(c3), vld1_u16(lzo_adler32_neon_taps + 20));
+        v_s2 = vmlal_u16(v_s2, vget_low_u16(c4),  vld1_u16(lzo_adler32_neon_taps + 24));
+        v_s2 = vmlal_u16(v_s2, vget_high_u16(c4), vld1_u16(lzo_adler32_neon_taps + 28));
+        t1 = vpadd_u32(vget_low_u32(v_s1), vget_high_u32(v_s1));
+        t2 = vpadd_u32(vget_low_u32(v_s2), vget_high_u32(v_s2));
+        t = vpadd_u32(t1, t2);
+        s1 = (s1 + vget_lane_u32(t, 0)) % LZO_BASE;
+        s2 = (s2 + vget_lane_u32(t, 1)) % LZO_BASE;
+    }
+    return lzo_adler32_scalar((s2 << 16) | s1, buf, len % 32);
+}
+#endif
+
+
+/***********************************************************************
+// dispatch
+************************************************************************/
+
+/* the scalar loop until lzo_init() has picked a kernel */
+static lzo_adler32_kernel_t lzo_adler32_impl = lzo_adler32_scalar;
+
+LZO_LOCAL_IMPL(void)
+_lzo_adler32_init(unsigned features)
+{
+#if defined(LZO_ADLER32_HAVE_X86)
+    if (features & LZO_CPU_F_AVX2)
+        lzo_adler32_impl = lzo_adler32_avx2;
+    else if (features & LZO_CPU_F_SSSE3)
+        lzo_adler32_impl = lzo_adler32_ssse3;
+#endif
+#if defined(LZO_ADLER32_HAVE_NEON)
+    if (features & LZO_CPU_F_NEON)
+        lzo_adler32_impl = lzo_adler32_neon;
+#endif
+    LZO_UNUSED(features);
+}
+
+
+LZO_PUBLIC(lzo_uint32_t)
+lzo_adler32(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+{
+    if (buf == NULL)
+        return 1;
+    return lzo_adler32_impl(adler, buf, len);
+}
+
 #undef LZO_DO1
 #undef LZO_DO2
 #undef LZO_DO4
@@ -145,4 +344,27 @@ lzo_adler32(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
 #undef LZO_DO16
 
 
+/***********************************************************************
+// adler32_combine
+// combine the adler32 of two adjacent buffers given the second one's length;
+// adapted from zlib's adler32_combine(), see above
+************************************************************************/
+
+LZO_PUBLIC(lzo_uint32_t)
+lzo_adler32_combine(lzo_uint32_t adler1, lzo_uint32_t adler2, lzo_uint len2)
+{
+    lzo_uint32_t rem = (lzo_uint32_t) (len2 % LZO_BASE);
+    lzo_uint32_t s1 = adler1 & 0xffff;
+    lzo_uint32_t s2 = (rem * s1) % LZO_BASE;
+
+    s1 += (adler2 & 0xffff) + LZO_BASE - 1;
+    s2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + LZO_BASE - rem;
+    if (s1 >= LZO_BASE) s1 -= LZO_BASE;
+    if (s1 >= LZO_BASE) s1 -= LZO_BASE;
+    if (s2 >= (LZO_BASE << 1)) s2 -= (LZO_BASE << 1);
+    if (s2 >= LZO_BASE) s2 -= LZO_BASE;
+    return (s2 << 16) | s1;
+}
+
+
 /* vim:set ts=4 sw=4 et: */
@@ -0,0 +1,194 @@
+/* lzo_vcopy.h -- wide literal and match copies for lzo1x_decompress_vec()
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+
+/* WARNING: this file should *not* be used by applications. It is
+   part of the implementation of the library and is subject
+   to change.
+ */
+
+
+#ifndef __LZO_VCOPY_H
+#define __LZO_VCOPY_H 1
+
+
+/***********************************************************************
+// The copies round the length up to whole vectors, so they may write
+// and read up to LZO_VCOPY_MARGIN - 1 bytes past the requested end.
+// Callers only take them when that much room is left in the output
+// and, for literals, in the input.
+//
+// The vector width follows the ISA of the including file: AVX2 copies
+// 32 bytes, SSE2 and NEON 16. Offsets below the width are expanded from
+// a pattern register (pshufb / tbl) where available.
+************************************************************************/
+
+#define LZO_VCOPY_MARGIN    32
+
+#if defined(__SSE2__) && (LZO_ARCH_AMD64 || LZO_ARCH_I386)
+#  define LZO_VCOPY_SSE2    1
+#  include <immintrin.h>
+#  if defined(__SSSE3__)
+#    define LZO_VCOPY_PSHUFB 1
+#  endif
+#  if defined(__AVX2__)
+#    define LZO_VCOPY_AVX2  1
+#  endif
+#elif defined(__ARM_NEON) && (LZO_ARCH_ARM64)
+#  define LZO_VCOPY_NEON    1
+#  include <arm_neon.h>
+#endif
+
+
+__lzo_static_forceinline void lzo_vcopy16(lzo_bytep d, const lzo_bytep s)
+{
+#if (LZO_VCOPY_SSE2)
+    _mm_storeu_si128((__m128i *) d, _mm_loadu_si128((const __m128i *) s));
+#elif (LZO_VCOPY_NEON)
+    vst1q_u8((uint8_t *) d, vld1q_u8((const uint8_t *) s));
+#elif (LZO_OPT_UNALIGNED64)
+    UA_COPY8(d, s); UA_COPY8(d + 8, s + 8);
+#else
+    lzo_memcpy(d, s, 16);
+#endif
+}
+
+/* copy n > 0 bytes; s must be at least one vector behind d, or apart */
+__lzo_static_forceinline void lzo_vcopy(lzo_bytep d, const lzo_bytep s, lzo_uint n)
+{
+    lzo_bytep const e = d + n;
+#if (LZO_VCOPY_AVX2)
+    do {
+        _mm256_storeu_si256((__m256i *) d, _mm256_loadu_si256((const __m256i *) s));
+        d += 32; s += 32;
+    } while (d < e);
+#else
+    do {
+        lzo_vcopy16(d, s);
+        d += 16; s += 16;
+    } while (d < e);
+#endif
+}
+
+#if (LZO_VCOPY_PSHUFB) || (LZO_VCOPY_NEON)
+/* byte i of the pattern for offset off is byte (i % off) of the source;
+ * a stored pattern stays in phase when advanced by lzo_vcopy_step[off] */
+static const unsigned char lzo_vcopy_shuf[16][16] = {
+    { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },
+    { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 },
+    { 0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1 },
+    { 0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0 },
+    { 0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3 },
+    { 0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0 },
+    { 0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3 },
+    { 0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1 },
+    { 0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7 },
+    { 0,1,2,3,4,5,6,7,8,0,1,2,3,4,5,6 },
+    { 0,1,2,3,4,5,6,7,8,9,0,1,2,3,4,5 },
+    { 0,1,2,3,4,5,6,7,8,9,10,0,1,2,3,4 },
+    { 0,1,2,3,4,5,6,7,8,9,10,11,0,1,2,3 },
+    { 0,1,2,3,4,5,6,7,8,9,10,11,12,0,1,2 },
+    { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,0,1 },
+    { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,0 }
+};
+static const unsigned char lzo_vcopy_step[16] = {
+    0, 16, 16, 15, 16, 15, 12, 14, 16, 9, 10, 11, 12, 13, 14, 15
+};
+#endif
+
+/* copy an n > 0 byte match from off bytes back */
+__lzo_static_forceinline void lzo_vcopy_match(lzo_bytep d, lzo_uint off, lzo_uint n)
+{
+    const lzo_bytep s = d - off;
+#if (LZO_VCOPY_AVX2)
+    if (off >= 32)
+    {
+        lzo_vcopy(d, s, n);
+        return;
+    }
+#endif
+    if (off >= 16)
+    {
+        lzo_bytep const e = d + n;
+        do {
+            lzo_vcopy16(d, s);
+            d += 16; s += 16;
+        } while (d < e);
+    }
+    else
+    {
+#if (LZO_VCOPY_PSHUFB) || (LZO_VCOPY_NEON)
+        lzo_bytep const e = d + n;
+        lzo_uint step = lzo_vcopy_step[off];
+#if (LZO_VCOPY_PSHUFB)
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) s),
+                                     _mm_loadu_si128((const __m128i *) lzo_vcopy_shuf[off]));
+        do {
+            _mm_storeu_si128((__m128i *) d, v);
+            d += step;
+        } while (d < e);
+#else
+        uint8x16_t v = vqtbl1q_u8(vld1q_u8((const uint8_t *) s), vld1q_u8(lzo_vcopy_shuf[off]));
+        do {
+            vst1q_u8((uint8_t *) d, v);
+            d += step;
+        } while (d < e);
+#endif
+#else
+#if (LZO_VCOPY_SSE2)
+        if (off == 1)
+        {
+            lzo_bytep const e = d + n;
+            __m128i v = _mm_set1_epi8((char) s[0]);
+            do {
+                _mm_storeu_si128((__m128i *) d, v);
+                d += 16;
+            } while (d < e);
+            return;
+        }
+#endif
+#if (LZO_OPT_UNALIGNED64)
+        if (off >= 8)
+        {
+            lzo_bytep const e = d + n;
+            do {
+                UA_COPY8(d, s);
+                d += 8; s += 8;
+            } while (d < e);
+            return;
+        }
+#endif
+        do *d++ = *s++; while (--n > 0);
+#endif
+    }
+}
+
+
+#endif /* already included */
+
+
+/* vim:set ts=4 sw=4 et: */
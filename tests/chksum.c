@@ -33,6 +33,43 @@
 #include "examples/portab.h"
 
 
+/*************************************************************************
+// bit-at-a-time crc32, the reference for the table and SIMD kernels
+**************************************************************************/
+
+static lzo_uint32_t ref_crc32(lzo_uint32_t c, const lzo_bytep buf, lzo_uint len)
+{
+    int k;
+
+    c = ~c & 0xffffffffUL;
+    while (len-- > 0)
+    {
+        c ^= *buf++;
+        for (k = 0; k < 8; k++)
+            c = (c >> 1) ^ (0xedb88320UL & (0 - (c & 1)));
+    }
+    return ~c & 0xffffffffUL;
+}
+
+
+/*************************************************************************
+// byte-at-a-time adler32, the reference for the SIMD kernels
+**************************************************************************/
+
+static lzo_uint32_t ref_adler32(lzo_uint32_t adler, const lzo_bytep buf, lzo_uint len)
+{
+    lzo_uint32_t s1 = adler & 0xffff;
+    lzo_uint32_t s2 = (adler >> 16) & 0xffff;
+
+    while (len-- > 0)
+    {
+        s1 = (s1 + *buf++) % 65521u;
+        s2 = (s2 + s1) % 65521u;
+    }
+    return (s2 << 16) | s1;
+}
+
+
 /*************************************************************************
 //
 **************************************************************************/
@@ -41,6 +78,7 @@ int main(int argc, char *argv[])
 {
     lzo_bytep block;
     lzo_uint block_size;
+    lzo_uint i;
     lzo_uint32_t adler, crc;
 
     if (argc < 0 && argv == NULL)   /* avoid warning about unused args */
@@ -80,6 +118,88 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+/* every length and alignment around the kernels' 8, 16 and 64 byte steps */
+    for (i = 0; i < block_size; i++)
+        block[i] = (unsigned char) (i * 131 + (i >> 7));
+    for (i = 0; i < 16; i++)
+    {
+        lzo_uint n;
+        for (n = 0; n <= 600; n++)
+        {
+            if (lzo_crc32(0x5a5a5a5aUL, block + i, n) != ref_crc32(0x5a5a5a5aUL, block + i, n))
+            {
+                printf("crc32 kernel error !!! (offset %lu, length %lu)\n",
+                       (unsigned long) i, (unsigned long) n);
+                return 1;
+            }
+        }
+    }
+    if (lzo_crc32(0, block, block_size) != ref_crc32(0, block, block_size))
+    {
+        printf("crc32 kernel error !!! (length %lu)\n", (unsigned long) block_size);
+        return 1;
+    }
+
+/* adler32 at random lengths and alignments, with high-valued bytes to
+ * stress the per-group overflow bounds */
+    {
+        lzo_uint32_t r = 12345;
+        for (i = 0; i < block_size; i++)
+        {
+            r = r * 1103515245UL + 12345;
+            block[i] = (unsigned char) ((r >> 24) | ((r & 0x100) ? 0xc0 : 0));
+        }
+        for (i = 0; i < 2000; i++)
+        {
+            lzo_uint off, n;
+            lzo_uint32_t seed;
+            r = r * 1103515245UL + 12345;
+            off = (r >> 16) & 31;
+            r = r * 1103515245UL + 12345;
+            n = (i < 1000) ? i : (r >> 8) % (block_size - off);
+            seed = r ^ (r >> 13);
+            seed = ((seed % 65521u) << 16) | ((seed >> 16) % 65521u);
+            if (lzo_adler32(seed, block + off, n) != ref_adler32(seed, block + off, n))
+            {
+                printf("adler32 kernel error !!! (offset %lu, length %lu)\n",
+                       (unsigned long) off, (unsigned long) n);
+                return 2;
+            }
+        }
+        for (i = 0; i < block_size; i++)
+            block[i] = 255;
+        if (lzo_adler32(0xfff0fff0UL, block, block_size) != ref_adler32(0xfff0fff0UL, block, block_size))
+        {
+            printf("adler32 kernel error !!! (length %lu)\n", (unsigned long) block_size);
+            return 2;
+        }
+    }
+
+/* combining the checksums of two parts must match the whole */
+    for (i = 0; i < block_size; i++)
+        block[i] = (unsigned char) (i * 7 + (i >> 9));
+    adler = lzo_adler32(lzo_adler32(0, NULL, 0), block, block_size);
+    crc = lzo_crc32(lzo_crc32(0, NULL, 0), block, block_size);
+    for (i = 0; i < 6; i++)
+    {
+        static const lzo_uint splits[6] = { 0, 1, 5552, 65521, 100000, 128 * 1024L };
+        lzo_uint n = splits[i];
+        lzo_uint32_t a1 = lzo_adler32(lzo_adler32(0, NULL, 0), block, n);
+        lzo_uint32_t a2 = lzo_adler32(lzo_adler32(0, NULL, 0), block + n, block_size - n);
+        lzo_uint32_t c1 = lzo_crc32(lzo_crc32(0, NULL, 0), block, n);
+        lzo_uint32_t c2 = lzo_crc32(lzo_crc32(0, NULL, 0), block + n, block_size - n);
+        if (lzo_adler32_combine(a1, a2, block_size - n) != adler)
+        {
+            printf("adler32_combine error !!! (split %lu)\n", (unsigned long) n);
+            return 2;
+        }
+        if (lzo_crc32_combine(c1, c2, block_size - n) != crc)
+        {
+            printf("crc32_combine error !!! (split %lu)\n", (unsigned long) n);
+            return 1;
+        }
+    }
+
     lzo_free(block);
     printf("Checksum test passed.\n");
     return 0;
@@ -0,0 +1,167 @@
+/* ctx999.c -- test the reusable LZO1X-999 context
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+
+#include <lzo/lzoconf.h>
+#include <lzo/lzo1x.h>
+
+/* utility layer */
+#define WANT_LZO_MALLOC 1
+#include "examples/portab.h"
+
+
+/*************************************************************************
+// every block compressed through one context must match a fresh
+// lzo1x_999_compress_level() call
+**************************************************************************/
+
+static lzo_bytep out1;
+static lzo_bytep out2;
+static lzo_bytep wrkmem;
+
+static int check_block(lzo1x_999_ctx_p ctx, int level,
+                       const lzo_bytep src, lzo_uint src_len,
+                       const lzo_bytep dict, lzo_uint dict_len)
+{
+    lzo_uint len1 = 0, len2 = 0;
+
+    if (lzo1x_999_compress_level(src, src_len, out1, &len1, wrkmem,
+                                 dict, dict_len, 0, level) != LZO_E_OK ||
+        lzo1x_999_ctx_compress(ctx, src, src_len, out2, &len2,
+                               dict, dict_len) != LZO_E_OK)
+    {
+        printf("compress error !!! (level %d, length %lu)\n", level, (unsigned long) src_len);
+        return 1;
+    }
+    if (len1 != len2 || lzo_memcmp(out1, out2, len1) != 0)
+    {
+        printf("context output differs !!! (level %d, length %lu: %lu vs %lu bytes)\n",
+               level, (unsigned long) src_len, (unsigned long) len1, (unsigned long) len2);
+        return 1;
+    }
+    return 0;
+}
+
+
+/*************************************************************************
+//
+**************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    lzo_bytep block;
+    lzo_bytep ctx_mem;
+    lzo1x_999_ctx_p ctx;
+    lzo_uint block_size;
+    lzo_uint i;
+    lzo_uint32_t r = 12345;
+    int level;
+
+    if (argc < 0 && argv == NULL)   /* avoid warning about unused args */
+        return 0;
+
+    if (lzo_init() != LZO_E_OK)
+    {
+        printf("lzo_init() failed !!!\n");
+        return 4;
+    }
+
+    block_size = 64 * 1024L;
+    block = (lzo_bytep) lzo_malloc(block_size);
+    out1 = (lzo_bytep) lzo_malloc(block_size + block_size / 16 + 64 + 3);
+    out2 = (lzo_bytep) lzo_malloc(block_size + block_size / 16 + 64 + 3);
+    wrkmem = (lzo_bytep) lzo_malloc(LZO1X_999_MEM_COMPRESS);
+    ctx_mem = (lzo_bytep) lzo_malloc(LZO1X_999_CTX_MEM_SIZE);
+    if (block == NULL || out1 == NULL || out2 == NULL || wrkmem == NULL || ctx_mem == NULL)
+    {
+        printf("out of memory\n");
+        return 3;
+    }
+
+/* text-like data: short words drawn from a small vocabulary */
+    for (i = 0; i < block_size; i++)
+    {
+        r = r * 1103515245UL + 12345;
+        block[i] = (unsigned char) ((r >> 28) < 3 ? ' ' : 'a' + ((r >> 16) % 12));
+    }
+
+/* levels outside 1 .. 10 are refused */
+    if (lzo1x_999_ctx_create(ctx_mem, 0) != NULL || lzo1x_999_ctx_create(ctx_mem, 11) != NULL)
+    {
+        printf("ctx_create accepted a bad level !!!\n");
+        return 2;
+    }
+    ctx = lzo1x_999_ctx_create(ctx_mem, 1);
+    if (ctx == NULL || lzo1x_999_ctx_reset(ctx, 0) == LZO_E_OK || lzo1x_999_ctx_reset(ctx, 11) == LZO_E_OK)
+    {
+        printf("ctx_create/ctx_reset level error !!!\n");
+        return 2;
+    }
+
+/* blocks of many sizes through the same context, at every level */
+    for (level = 1; level <= 10; level++)
+    {
+        if (lzo1x_999_ctx_reset(ctx, level) != LZO_E_OK)
+        {
+            printf("ctx_reset error !!! (level %d)\n", level);
+            return 2;
+        }
+        for (i = 0; i < 8; i++)
+        {
+            static const lzo_uint lens[8] = { 0, 1, 3, 100, 4096, 20000, 65536, 777 };
+            lzo_uint n = lens[i];
+            lzo_uint off = (i * 4099) % (block_size - n + 1);
+            if (check_block(ctx, level, block + off, n, NULL, 0) != 0)
+                return 1;
+            if (n >= 100 && check_block(ctx, level, block + off, n, block, 2048) != 0)
+                return 1;
+        }
+    }
+
+/* a destroyed context must refuse to compress */
+    lzo1x_999_ctx_destroy(ctx);
+    {
+        lzo_uint len = 0;
+        if (lzo1x_999_ctx_compress(ctx, block, 100, out2, &len, NULL, 0) != LZO_E_ERROR)
+        {
+            printf("destroyed context still compresses !!!\n");
+            return 2;
+        }
+    }
+    lzo1x_999_ctx_destroy(NULL);
+
+    lzo_free(ctx_mem);
+    lzo_free(wrkmem);
+    lzo_free(out2);
+    lzo_free(out1);
+    lzo_free(block);
+    printf("LZO1X-999 context test passed.\n");
+    return 0;
+}
+
+
+/* vim:set ts=4 sw=4 et: */
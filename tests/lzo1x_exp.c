@@ -0,0 +1,140 @@
+/* lzo1x_exp.c -- check an experimental LZO1X-1 compressor option
+
+   This file is part of the LZO real-time data compression library.
+
+   Copyright (C) 1996-2017 Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   The LZO library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   The LZO library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with the LZO library; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+   http://www.oberhumer.com/opensource/lzo/
+ */
+
+
+
+/* This file is built once for each experimental option of lzo1x_c.ch
+ * that no library build enables (see CMakeLists.txt). The compressor it
+ * builds must give exactly the output of the library's lzo1x_1_compress().
+ */
+#define DO_COMPRESS     lzo1x_1_compress_exp
+#include "src/lzo1x_1.c"
+
+/* utility layer */
+#define WANT_LZO_MALLOC 1
+#include "examples/portab.h"
+
+
+/*************************************************************************
+//
+**************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    lzo_bytep block;
+    lzo_bytep out1;
+    lzo_bytep out2;
+    lzo_bytep wrkmem;
+    lzo_uint block_size;
+    lzo_uint i;
+    lzo_uint32_t r = 12345;
+
+    if (argc < 0 && argv == NULL)   /* avoid warning about unused args */
+        return 0;
+
+    if (lzo_init() != LZO_E_OK)
+    {
+        printf("lzo_init() failed !!!\n");
+        return 4;
+    }
+
+    block_size = 256 * 1024L;
+    block = (lzo_bytep) lzo_malloc(block_size);
+    out1 = (lzo_bytep) lzo_malloc(block_size + block_size / 16 + 64 + 3);
+    out2 = (lzo_bytep) lzo_malloc(block_size + block_size / 16 + 64 + 3);
+    wrkmem = (lzo_bytep) lzo_malloc(LZO1X_1_MEM_COMPRESS);
+    if (block == NULL || out1 == NULL || out2 == NULL || wrkmem == NULL)
+    {
+        printf("out of memory\n");
+        return 3;
+    }
+
+/* runs, literals and copies of earlier data at near and far distances */
+    for (i = 0; i < block_size; )
+    {
+        lzo_uint n, k;
+        r = r * 1103515245UL + 12345;
+        n = 1 + ((r >> 16) & 255);
+        if (n > block_size - i)
+            n = block_size - i;
+        switch ((r >> 8) & 3)
+        {
+        case 0:
+            lzo_memset(block + i, (int) (r >> 24), n);
+            break;
+        case 1:
+            for (k = 0; k < n; k++)
+            {
+                r = r * 1103515245UL + 12345;
+                block[i + k] = (unsigned char) (r >> 24);
+            }
+            break;
+        default:
+            k = (r >> 2) % (i < 0xbfff ? i + 1 : 0xbfff);
+            for ( ; n > 0 && k > 0; n--, i++)
+                block[i] = block[i - k];
+            continue;
+        }
+        i += n;
+    }
+
+/* lengths around the 48 KiB passes of the deterministic dictionary */
+    for (i = 0; i < 9; i++)
+    {
+        static const lzo_uint lens[9] = { 0, 1, 100, 49151, 49152, 49153, 100000, 196609, 256 * 1024L };
+        lzo_uint n = lens[i];
+        lzo_uint len1 = 0, len2 = 0, dst_len = n;
+        if (lzo1x_1_compress(block, n, out1, &len1, wrkmem) != LZO_E_OK ||
+            lzo1x_1_compress_exp(block, n, out2, &len2, wrkmem) != LZO_E_OK)
+        {
+            printf("compress error !!! (length %lu)\n", (unsigned long) n);
+            return 1;
+        }
+        if (len1 != len2 || lzo_memcmp(out1, out2, len1) != 0)
+        {
+            printf("output differs from lzo1x_1_compress() !!! (length %lu: %lu vs %lu bytes)\n",
+                   (unsigned long) n, (unsigned long) len1, (unsigned long) len2);
+            return 1;
+        }
+        if (lzo1x_decompress_safe(out2, len2, out1, &dst_len, NULL) != LZO_E_OK ||
+            dst_len != n || lzo_memcmp(out1, block, n) != 0)
+        {
+            printf("decompress error !!! (length %lu)\n", (unsigned long) n);
+            return 1;
+        }
+    }
+
+    lzo_free(wrkmem);
+    lzo_free(out2);
+    lzo_free(out1);
+    lzo_free(block);
+    printf("Experimental LZO1X-1 option test passed.\n");
+    return 0;
+}
+
+
+/* vim:set ts=4 sw=4 et: */
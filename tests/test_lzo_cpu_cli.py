@@ -20,6 +20,7 @@ from __future__ import annotations
 import argparse
 import os
 import shutil
+import struct
 import subprocess
 import sys
 import tempfile
@@ -30,8 +31,13 @@ REPO_ROOT = Path(__file__).resolve().parents[1]
 DEFAULT_CLI_CANDIDATES = (
     REPO_ROOT / "lzo_cpu" / "lzo_frag.exe",
     REPO_ROOT / "lzo_cpu" / "lzo_frag",
+    REPO_ROOT / "lzo_cpu" / "lzo_cpu.exe",
+    REPO_ROOT / "lzo_cpu" / "lzo_cpu",
 )
 
+# Numeric levels map onto -L labels the same way alg_from_level() does.
+LEVEL_LABELS = {1: "1l", 2: "1k", 3: "1", 4: "1o"}
+
 
 class CLIError(RuntimeError):
     """Raised when the CLI returns a failing exit status."""
@@ -96,7 +102,7 @@ def roundtrip(
     compressed = tmpdir / f"{fixture.name}.{suffix}.lzo"
     restored = tmpdir / f"{fixture.name}.{suffix}.out"
 
-    compress_args = [f"-{level}", "-t", str(threads)]
+    compress_args = ["-L", LEVEL_LABELS[level], "-t", str(threads)]
     if benchmark:
         compress_args.append("--benchmark")
     compress_args.extend([str(fixture), str(compressed)])
@@ -116,6 +122,255 @@ def roundtrip(
         )
 
 
+def accel_roundtrip(cli: Path, fixture: Path, tmpdir: Path, threads: int) -> None:
+    plain = tmpdir / f"{fixture.name}.t{threads}.a0.lzo"
+    run_cli(cli, ["-L", "1", "-t", str(threads), str(fixture), str(plain)])
+    for accel in ("1", "16", "65536"):
+        compressed = tmpdir / f"{fixture.name}.t{threads}.a{accel}.lzo"
+        restored = tmpdir / f"{fixture.name}.t{threads}.a{accel}.out"
+        run_cli(cli, ["-L", f"1:{accel}", "-t", str(threads), str(fixture), str(compressed)])
+        # Acceleration 1 is plain LZO1X-1 and must not change a byte.
+        if accel == "1" and compressed.read_bytes() != plain.read_bytes():
+            raise AssertionError(f"-L 1:1 output differs from -L 1: {compressed}")
+        run_cli(cli, ["-d", "-t", str(threads), str(compressed), str(restored)])
+        if fixture.read_bytes() != restored.read_bytes():
+            raise AssertionError(f"Acceleration {accel} mismatch for threads {threads}: {restored}")
+
+
+def stream_roundtrip(cli: Path, fixture: Path, tmpdir: Path, threads: int) -> None:
+    compressed = tmpdir / f"{fixture.name}.t{threads}.stream.lzo"
+    restored = tmpdir / f"{fixture.name}.t{threads}.stream.out"
+    run_cli(cli, ["--stream", "-t", str(threads), str(fixture), str(compressed)])
+
+    # Streamed containers decode both incrementally and via the in-memory path.
+    run_cli(cli, ["-d", "--stream", "-t", str(threads), str(compressed), str(restored)])
+    if fixture.read_bytes() != restored.read_bytes():
+        raise AssertionError(f"Stream content mismatch for threads {threads}: {restored}")
+    run_cli(cli, ["-d", "-t", str(threads), str(compressed), str(restored)])
+    if fixture.read_bytes() != restored.read_bytes():
+        raise AssertionError(f"Stream container mismatch for threads {threads}: {restored}")
+
+    # Every I/O backend must produce the same stream as the default one.
+    for io in ("thread", "sync"):
+        alt = tmpdir / f"{fixture.name}.t{threads}.stream.{io}.lzo"
+        run_cli(cli, ["--stream", "--io", io, "-t", str(threads), str(fixture), str(alt)])
+        if alt.read_bytes() != compressed.read_bytes():
+            raise AssertionError(f"Stream output differs with --io {io}: {alt}")
+        run_cli(cli, ["-d", "--stream", "--io", io, "-t", str(threads), str(alt), str(restored)])
+        if fixture.read_bytes() != restored.read_bytes():
+            raise AssertionError(f"Stream mismatch with --io {io}: {restored}")
+
+
+def format2_roundtrip(cli: Path, fixture: Path, tmpdir: Path, threads: int) -> None:
+    compressed = tmpdir / f"{fixture.name}.t{threads}.v2.lzo"
+    restored = tmpdir / f"{fixture.name}.t{threads}.v2.out"
+    run_cli(cli, ["--format", "2", "-t", str(threads), str(fixture), str(compressed)])
+    if compressed.read_bytes()[:2] != b"\x5b\x4c":
+        raise AssertionError(f"Expected a v2 container header in {compressed}")
+    run_cli(cli, ["-d", "-t", str(threads), str(compressed), str(restored)])
+    if fixture.read_bytes() != restored.read_bytes():
+        raise AssertionError(f"v2 content mismatch for threads {threads}: {restored}")
+
+
+def sched_roundtrip(cli: Path, fixture: Path, tmpdir: Path, threads: int) -> None:
+    # The default scheduler is covered by roundtrip(); exercise the other one.
+    compressed = tmpdir / f"{fixture.name}.t{threads}.atomic.lzo"
+    restored = tmpdir / f"{fixture.name}.t{threads}.atomic.out"
+    run_cli(cli, ["--sched", "atomic", "-t", str(threads), str(fixture), str(compressed)])
+    run_cli(cli, ["-d", "--sched", "atomic", "-t", str(threads), str(compressed), str(restored)])
+    if fixture.read_bytes() != restored.read_bytes():
+        raise AssertionError(f"Atomic scheduler mismatch for threads {threads}: {restored}")
+
+
+def block_size_roundtrip(cli: Path, fixture: Path, tmpdir: Path) -> None:
+    for block in ("auto", "65536"):
+        compressed = tmpdir / f"{fixture.name}.b{block}.lzo"
+        restored = tmpdir / f"{fixture.name}.b{block}.out"
+        run_cli(cli, ["--block-size", block, "-t", "2", str(fixture), str(compressed)])
+        run_cli(cli, ["-d", str(compressed), str(restored)])
+        if fixture.read_bytes() != restored.read_bytes():
+            raise AssertionError(f"Block size {block} mismatch: {restored}")
+
+
+def range_extract(cli: Path, fixture: Path, tmpdir: Path) -> None:
+    original = fixture.read_bytes()
+    for index in (False, True):
+        tag = "indexed" if index else "plain"
+        compressed = tmpdir / f"{fixture.name}.{tag}.lzo"
+        compress_args = ["--index"] if index else []
+        run_cli(cli, [*compress_args, str(fixture), str(compressed)])
+        for off, length in ((0, 1), (300, 5000), (len(original) - 17, 17)):
+            restored = tmpdir / f"{fixture.name}.{tag}.{off}.range"
+            run_cli(cli, ["-d", "--range", f"{off}:{length}", str(compressed), str(restored)])
+            if restored.read_bytes() != original[off : off + length]:
+                raise AssertionError(f"Range {off}:{length} mismatch ({tag}): {restored}")
+    # v1 headers whose block count does not match orig_size / blk_size
+    for nblk in (0, 1):
+        damaged = tmpdir / f"range.nblk{nblk}.lzo"
+        damaged.write_bytes(struct.pack("<HIII", 0x4C5A, 1000, 100, nblk) + b"\0" * 4 * nblk)
+        restored = tmpdir / f"range.nblk{nblk}.out"
+        proc = subprocess.run([str(cli), "-d", "--range", "500:1", str(damaged), str(restored)],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        if proc.returncode == 0 or b"inconsistent container header" not in proc.stderr:
+            raise AssertionError(f"Inconsistent header was not rejected: {damaged}")
+    # damaged block payloads must fail cleanly, not overrun the decode buffers
+    source = tmpdir / "range.multi.bin"
+    source.write_bytes(original * 6)
+    compressed = tmpdir / "range.multi.lzo"
+    run_cli(cli, ["--index", "--checksum", "crc32", "--block-size", "65536",
+                  str(source), str(compressed)])
+    data = bytearray(compressed.read_bytes())
+    nblk = struct.unpack_from("<Q", data, 16)[0]
+    lens = [n & 0x7FFFFFFF for n in struct.unpack_from(f"<{nblk}I", data, 24)]
+    # the start of block 0 codes the byte runs, so this is deterministic
+    payload = len(data) - sum(lens)
+    data[payload + 14 : payload + 18] = b"\xff" * 4
+    damaged = tmpdir / "range.payload.lzo"
+    damaged.write_bytes(bytes(data))
+    restored = tmpdir / "range.payload.out"
+    proc = subprocess.run([str(cli), "-d", "--range", "1000:150000", str(damaged), str(restored)],
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if proc.returncode != 1 or b"range decompress failed" not in proc.stderr:
+        raise AssertionError(f"Damaged payload was not rejected: {damaged}")
+
+
+def corrupt_decode(cli: Path, fixture: Path, tmpdir: Path) -> None:
+    source = tmpdir / "corrupt.bin"
+    source.write_bytes(fixture.read_bytes() * 6)
+    whole = tmpdir / "corrupt.lzo"
+    stream = tmpdir / "corrupt.stream.lzo"
+    run_cli(cli, [str(source), str(whole)])
+    run_cli(cli, ["--stream", str(source), str(stream)])
+
+    # v1: 14-byte header and one u32 length per block, then the payload;
+    # the start of block 0 codes the byte runs, so this is deterministic
+    data = bytearray(whole.read_bytes())
+    payload = 14 + 4 * struct.unpack_from("<I", data, 10)[0]
+    data[payload + 14 : payload + 18] = b"\xff" * 4
+    damaged = [("whole", data, [])]
+    # stream: 6-byte header, then u32 raw_len, u32 comp_len and the data
+    data = bytearray(stream.read_bytes())
+    data[28:32] = b"\xff" * 4
+    damaged.append(("stream", data, ["--stream"]))
+    # a frame that decodes to fewer bytes than its raw_len claims
+    data = bytearray(stream.read_bytes())
+    struct.pack_into("<I", data, 6, struct.unpack_from("<I", data, 6)[0] + 1)
+    damaged.append(("short", data, ["--stream"]))
+
+    for tag, data, extra in damaged:
+        path = tmpdir / f"corrupt.{tag}.lzo"
+        path.write_bytes(bytes(data))
+        restored = tmpdir / f"corrupt.{tag}.out"
+        proc = subprocess.run([str(cli), "-d", *extra, str(path), str(restored)],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        if proc.returncode != 1 or b"decompress failed" not in proc.stderr:
+            raise AssertionError(f"Damaged {tag} container was not rejected: {path}")
+
+
+def stored_roundtrip(cli: Path, tmpdir: Path) -> None:
+    # random blocks are stored raw, the text block between them is not
+    data = os.urandom(2 * 65536) + b"stored block test\n" * 3641 + os.urandom(4 * 65536)
+    source = tmpdir / "stored.bin"
+    source.write_bytes(data)
+    compressed = tmpdir / "stored.lzo"
+    run_cli(cli, ["--index", "--block-size", "65536", str(source), str(compressed)])
+    if not compressed.read_bytes()[3] & 0x02:
+        raise AssertionError(f"Expected stored blocks in {compressed}")
+    restored = tmpdir / "stored.out"
+    run_cli(cli, ["-d", str(compressed), str(restored)])
+    if restored.read_bytes() != data:
+        raise AssertionError(f"Stored block mismatch: {restored}")
+    off, length = 65536 + 100, 2 * 65536
+    run_cli(cli, ["-d", "--range", f"{off}:{length}", str(compressed), str(restored)])
+    if restored.read_bytes() != data[off : off + length]:
+        raise AssertionError(f"Stored block range mismatch: {restored}")
+    run_cli(cli, ["--stream", str(source), str(compressed)])
+    run_cli(cli, ["-d", "--stream", str(compressed), str(restored)])
+    if restored.read_bytes() != data:
+        raise AssertionError(f"Stored stream frame mismatch: {restored}")
+
+
+def checksum_roundtrip(cli: Path, fixture: Path, tmpdir: Path) -> None:
+    for kind in ("crc32", "adler32"):
+        compressed = tmpdir / f"{fixture.name}.{kind}.lzo"
+        restored = tmpdir / f"{fixture.name}.{kind}.out"
+        run_cli(cli, ["--checksum", kind, "--block-size", "65536", str(fixture), str(compressed)])
+        run_cli(cli, ["-d", str(compressed), str(restored)])
+        if fixture.read_bytes() != restored.read_bytes():
+            raise AssertionError(f"Checksum {kind} roundtrip mismatch: {restored}")
+        # flip a bit in the fixture's trailing literals: the block still
+        # decodes, so only its checksum can reject it
+        damaged = bytearray(compressed.read_bytes())
+        damaged[-20] ^= 0x01
+        compressed.write_bytes(bytes(damaged))
+        proc = subprocess.run([str(cli), "-d", str(compressed), str(restored)],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        if proc.returncode == 0 or b"checksum mismatch" not in proc.stderr:
+            raise AssertionError(f"Corrupted {kind} container was not rejected: {compressed}")
+
+
+def chain_roundtrip(cli: Path, tmpdir: Path) -> None:
+    # the random record repeats across block boundaries, so chained blocks
+    # must reach back into the history of the block before them
+    record = os.urandom(4000)
+    data = b"".join(record + b"chained block %d\n" % i for i in range(60))
+    source = tmpdir / "chain.bin"
+    source.write_bytes(data)
+    sizes = {}
+    for tag, extra in (("plain", ["-L", "999"]), ("chain", ["-L", "999:5", "--chain"]),
+                       ("optimal", ["-L", "999:10"])):
+        compressed = tmpdir / f"chain.{tag}.lzo"
+        restored = tmpdir / f"chain.{tag}.out"
+        run_cli(cli, [*extra, "--block-size", "65536", "-t", "2", str(source), str(compressed)])
+        run_cli(cli, ["-d", "-t", "2", str(compressed), str(restored)])
+        if restored.read_bytes() != data:
+            raise AssertionError(f"LZO1X-999 {tag} roundtrip mismatch: {restored}")
+        sizes[tag] = len(compressed.read_bytes())
+    compressed = tmpdir / "chain.chain.lzo"
+    if not compressed.read_bytes()[3] & 0x10:
+        raise AssertionError(f"Expected a chained container in {compressed}")
+    if sizes["chain"] >= sizes["plain"]:
+        raise AssertionError(f"Chained blocks did not compress better: {sizes}")
+    restored = tmpdir / "chain.range"
+    proc = subprocess.run([str(cli), "-d", "--range", "0:100", str(compressed), str(restored)],
+                          stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if proc.returncode == 0:
+        raise AssertionError(f"Range extraction from a chained container succeeded: {compressed}")
+
+
+def dict_roundtrip(cli: Path, tmpdir: Path) -> None:
+    # a small message made of records from the dictionary only compresses
+    # well when the blocks can match into it
+    records = [os.urandom(40) + b"dictionary record %d\n" % i for i in range(64)]
+    dictionary = tmpdir / "dict.bin"
+    dictionary.write_bytes(b"".join(records))
+    data = b"".join(records[i] for i in range(0, 64, 3))
+    source = tmpdir / "dict.msg"
+    source.write_bytes(data)
+    sizes = {}
+    for tag, extra in (("plain", []), ("dict", ["--dict", str(dictionary)]),
+                       ("dict999", ["-L", "999", "--dict", str(dictionary)])):
+        compressed = tmpdir / f"dict.{tag}.lzo"
+        restored = tmpdir / f"dict.{tag}.out"
+        run_cli(cli, [*extra, str(source), str(compressed)])
+        run_cli(cli, ["-d", *extra[-2:], str(compressed), str(restored)])
+        if restored.read_bytes() != data:
+            raise AssertionError(f"Dictionary {tag} roundtrip mismatch: {restored}")
+        sizes[tag] = len(compressed.read_bytes())
+    if sizes["dict"] >= sizes["plain"] // 2:
+        raise AssertionError(f"The dictionary did not help: {sizes}")
+    compressed = tmpdir / "dict.dict.lzo"
+    restored = tmpdir / "dict.range"
+    run_cli(cli, ["-d", "--dict", str(dictionary), "--range", "100:200", str(compressed), str(restored)])
+    if restored.read_bytes() != data[100:300]:
+        raise AssertionError(f"Dictionary range mismatch: {restored}")
+    for extra in ([], ["--dict", str(source)]):
+        proc = subprocess.run([str(cli), "-d", *extra, str(compressed), str(restored)],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        if proc.returncode == 0:
+            raise AssertionError(f"Decoding without the right dictionary succeeded: {extra}")
+
+
 def parse_csv_ints(value: str) -> List[int]:
     result: List[int] = []
     for item in value.split(","):
@@ -194,6 +449,29 @@ def main(argv: List[str] | None = None) -> int:
             for threads in args.threads:
                 print(f"- Roundtrip level={level} threads={threads}")
                 roundtrip(cli_path, fixture, workdir, level, threads, args.benchmark)
+        for threads in args.threads:
+            print(f"- Acceleration roundtrip threads={threads}")
+            accel_roundtrip(cli_path, fixture, workdir, threads)
+            print(f"- Stream roundtrip threads={threads}")
+            stream_roundtrip(cli_path, fixture, workdir, threads)
+            print(f"- Format 2 roundtrip threads={threads}")
+            format2_roundtrip(cli_path, fixture, workdir, threads)
+            print(f"- Atomic scheduler roundtrip threads={threads}")
+            sched_roundtrip(cli_path, fixture, workdir, threads)
+        print("- Block size selection")
+        block_size_roundtrip(cli_path, fixture, workdir)
+        print("- Range extraction")
+        range_extract(cli_path, fixture, workdir)
+        print("- Damaged containers")
+        corrupt_decode(cli_path, fixture, workdir)
+        print("- Stored blocks")
+        stored_roundtrip(cli_path, workdir)
+        print("- Block checksums")
+        checksum_roundtrip(cli_path, fixture, workdir)
+        print("- LZO1X-999 chained blocks")
+        chain_roundtrip(cli_path, workdir)
+        print("- Preset dictionary")
+        dict_roundtrip(cli_path, workdir)
     except Exception as exc:
         print(f"ERROR: {exc}", file=sys.stderr)
         return 1